@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Counts global heap allocations when the build defines TETRIS_COUNT_ALLOCATIONS,
+// so steady-state code paths can be checked for allocations. The replacement
+// operator new/delete are defined in this header: include it from exactly one
+// translation unit of each executable.
+namespace AllocationCounter {
+    inline std::atomic<std::uint64_t> allocations{ 0 };
+    inline std::atomic<std::uint64_t> bytes{ 0 };
+
+    inline std::uint64_t count() {
+        return allocations.load(std::memory_order_relaxed);
+    }
+
+    inline std::uint64_t totalBytes() {
+        return bytes.load(std::memory_order_relaxed);
+    }
+
+    inline bool isEnabled() {
+#ifdef TETRIS_COUNT_ALLOCATIONS
+        return true;
+#else
+        return false;
+#endif
+    }
+}
+
+#ifdef TETRIS_COUNT_ALLOCATIONS
+#include <cstdlib>
+#include <new>
+
+void* operator new(std::size_t size) {
+    AllocationCounter::allocations.fetch_add(1, std::memory_order_relaxed);
+    AllocationCounter::bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+#endif
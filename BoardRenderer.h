@@ -0,0 +1,71 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+// Collects every cell and block of a frame into one quad array textured from a
+// single atlas, so the playfield, ghost, current piece and previews are drawn
+// with one draw call. The atlas holds the seven block images side by side plus
+// a white slot used for untextured (solid color) quads.
+class BoardRenderer {
+public:
+    static const int BLOCK_TYPES = 7;
+
+    BoardRenderer() : vertices(sf::Quads) {}
+
+    void loadAtlas(const std::array<sf::Image, BLOCK_TYPES>& blockImages) {
+        unsigned int slotWidth = 1;
+        unsigned int slotHeight = 1;
+        for (const auto& image : blockImages) {
+            slotWidth = std::max(slotWidth, image.getSize().x);
+            slotHeight = std::max(slotHeight, image.getSize().y);
+        }
+
+        sf::Image atlasImage;
+        atlasImage.create(slotWidth * (BLOCK_TYPES + 1), slotHeight, sf::Color::White);
+        for (int i = 0; i < BLOCK_TYPES; ++i) {
+            sf::Vector2u size = blockImages[i].getSize();
+            atlasImage.copy(blockImages[i], i * slotWidth, 0);
+            blockRects[i] = sf::FloatRect(static_cast<float>(i * slotWidth), 0.0f,
+                static_cast<float>(size.x), static_cast<float>(size.y));
+        }
+        whiteTexel = sf::Vector2f(slotWidth * BLOCK_TYPES + slotWidth / 2.0f, slotHeight / 2.0f);
+
+        if (!atlas.loadFromImage(atlasImage)) {
+            throw std::runtime_error("Failed to create block texture atlas");
+        }
+    }
+
+    void clear() {
+        vertices.clear();
+    }
+
+    void addRect(float x, float y, float width, float height, const sf::Color& color) {
+        vertices.append(sf::Vertex(sf::Vector2f(x, y), color, whiteTexel));
+        vertices.append(sf::Vertex(sf::Vector2f(x + width, y), color, whiteTexel));
+        vertices.append(sf::Vertex(sf::Vector2f(x + width, y + height), color, whiteTexel));
+        vertices.append(sf::Vertex(sf::Vector2f(x, y + height), color, whiteTexel));
+    }
+
+    void addBlock(float x, float y, float size, int type) {
+        const sf::FloatRect& rect = blockRects[type];
+        float right = rect.left + rect.width;
+        float bottom = rect.top + rect.height;
+        vertices.append(sf::Vertex(sf::Vector2f(x, y), sf::Vector2f(rect.left, rect.top)));
+        vertices.append(sf::Vertex(sf::Vector2f(x + size, y), sf::Vector2f(right, rect.top)));
+        vertices.append(sf::Vertex(sf::Vector2f(x + size, y + size), sf::Vector2f(right, bottom)));
+        vertices.append(sf::Vertex(sf::Vector2f(x, y + size), sf::Vector2f(rect.left, bottom)));
+    }
+
+    void draw(sf::RenderTarget& target) const {
+        target.draw(vertices, &atlas);
+    }
+
+private:
+    sf::Texture atlas;
+    std::array<sf::FloatRect, BLOCK_TYPES> blockRects;
+    sf::Vector2f whiteTexel;
+    sf::VertexArray vertices;
+};
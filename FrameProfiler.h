@@ -0,0 +1,251 @@
+#pragma once
+
+#include "engine/SpscQueue.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+enum class ProfilePhase : std::uint8_t {
+    Events,
+    Update,
+    DrawUI,
+    DrawGridBackground,
+    DrawPieces,
+    Particles,
+    Overlay,
+    Display,
+    Count
+};
+
+const char* const PROFILE_PHASE_NAMES[] = {
+    "events", "update", "drawUI", "drawGridBackground", "drawPieces", "particles", "overlay", "display"
+};
+
+// What else happened in a frame, so hitches can be matched to their cause.
+namespace FrameFlags {
+    const std::uint8_t Lock = 1;
+    const std::uint8_t LineClear = 2;
+    const std::uint8_t BoardRedraw = 4;
+    const std::uint8_t ChromeRedraw = 8;
+}
+
+// Collects scoped phase timings through lock-free queues, one for the render
+// thread that owns the frame loop and one for the simulation thread, and folds
+// them into a fixed ring of per-frame records once per frame. Frames slower than
+// the hitch threshold are logged as they happen; the retained history can be
+// written as CSV or as a Chrome trace (chrome://tracing, Perfetto). Nothing
+// allocates after construction except hitch logging and the dumps.
+class FrameProfiler {
+public:
+    static const int PHASE_COUNT = static_cast<int>(ProfilePhase::Count);
+    static const int RENDER_THREAD = 0;
+    static const int SIMULATION_THREAD = 1;
+    static const std::size_t HISTORY = 3600;
+    static const std::size_t OVERLAY_WINDOW = 600;
+
+    struct FrameRecord {
+        std::uint64_t index = 0;
+        std::uint64_t startNs = 0;
+        std::uint64_t totalNs = 0;
+        std::array<std::uint64_t, PHASE_COUNT> phaseNs{};
+        std::uint8_t flags = 0;
+    };
+
+    explicit FrameProfiler(double hitchMs = 1000.0 / 60.0 * 1.25)
+        : samples{ { SpscQueue<Sample>(256), SpscQueue<Sample>(256) } }, frames(HISTORY), trace(HISTORY * PHASE_COUNT), scratch(OVERLAY_WINDOW),
+        epoch(std::chrono::steady_clock::now()), hitchNs(static_cast<std::uint64_t>(hitchMs * 1e6)) {}
+
+    std::uint64_t now() const {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - epoch).count());
+    }
+
+    void record(ProfilePhase phase, std::uint64_t startNs, std::uint64_t endNs, int thread = RENDER_THREAD) {
+        if (!samples[thread].tryPush(Sample{ phase, static_cast<std::uint8_t>(thread), startNs, endNs })) {
+            droppedSamples.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void beginFrame() {
+        current = FrameRecord();
+        current.index = frameCount;
+        current.startNs = now();
+    }
+
+    // May be called from either thread.
+    void flag(std::uint8_t flags) {
+        pendingFlags.fetch_or(flags, std::memory_order_relaxed);
+    }
+
+    void endFrame() {
+        current.totalNs = now() - current.startNs;
+        current.flags = pendingFlags.exchange(0, std::memory_order_relaxed);
+
+        Sample sample;
+        for (auto& queue : samples) {
+            while (queue.tryPop(sample)) {
+                current.phaseNs[static_cast<int>(sample.phase)] += sample.endNs - sample.startNs;
+                trace[traceCount++ % trace.size()] = sample;
+            }
+        }
+        frames[frameCount++ % HISTORY] = current;
+
+        if (current.totalNs > hitchNs) {
+            hitchCount++;
+            if (hitchLog) {
+                writeHitch(*hitchLog, current);
+            }
+        }
+    }
+
+    // Hitches go to this stream (nullptr to silence them).
+    void setHitchLog(std::ostream* log) {
+        hitchLog = log;
+    }
+
+    std::uint64_t getFrameCount() const { return frameCount; }
+    std::uint64_t getHitchCount() const { return hitchCount; }
+    std::uint64_t getDroppedSamples() const { return droppedSamples.load(std::memory_order_relaxed); }
+
+    // Frame time percentile (0-100) over the last OVERLAY_WINDOW frames, in milliseconds.
+    double percentileMs(double percentile) {
+        std::size_t count = std::min<std::uint64_t>(frameCount, OVERLAY_WINDOW);
+        if (count == 0) return 0.0;
+        for (std::size_t i = 0; i < count; ++i) {
+            scratch[i] = recent(i).totalNs;
+        }
+        std::size_t rank = std::min(count - 1, static_cast<std::size_t>(percentile / 100.0 * count));
+        std::nth_element(scratch.begin(), scratch.begin() + rank, scratch.begin() + count);
+        return scratch[rank] / 1e6;
+    }
+
+    double phaseMeanMs(ProfilePhase phase) const {
+        std::size_t count = std::min<std::uint64_t>(frameCount, OVERLAY_WINDOW);
+        if (count == 0) return 0.0;
+        std::uint64_t total = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            total += recent(i).phaseNs[static_cast<int>(phase)];
+        }
+        return total / 1e6 / count;
+    }
+
+    bool writeCsv(const std::string& path) const {
+        std::ofstream file(path);
+        if (!file.is_open()) return false;
+        file << "frame,start_ms,total_ms";
+        for (const char* name : PROFILE_PHASE_NAMES) {
+            file << "," << name << "_ms";
+        }
+        file << ",flags\n";
+        for (std::size_t i = retainedFrames(); i-- > 0;) {
+            const FrameRecord& frame = recent(i);
+            file << frame.index << "," << frame.startNs / 1e6 << "," << frame.totalNs / 1e6;
+            for (std::uint64_t ns : frame.phaseNs) {
+                file << "," << ns / 1e6;
+            }
+            file << "," << static_cast<int>(frame.flags) << "\n";
+        }
+        return file.good();
+    }
+
+    bool writeChromeTrace(const std::string& path) const {
+        std::ofstream file(path);
+        if (!file.is_open()) return false;
+        file << "{\"traceEvents\":[\n";
+        bool first = true;
+        auto event = [&](const char* name, int thread, std::uint64_t startNs, std::uint64_t durationNs) {
+            file << (first ? "" : ",\n") << "{\"name\":\"" << name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread + 1 << ",\"ts\":"
+                << startNs / 1000.0 << ",\"dur\":" << durationNs / 1000.0 << "}";
+            first = false;
+        };
+        for (std::size_t i = retainedFrames(); i-- > 0;) {
+            const FrameRecord& frame = recent(i);
+            event("frame", RENDER_THREAD, frame.startNs, frame.totalNs);
+        }
+        std::size_t retainedSamples = std::min<std::uint64_t>(traceCount, trace.size());
+        for (std::size_t i = traceCount - retainedSamples; i < traceCount; ++i) {
+            const Sample& sample = trace[i % trace.size()];
+            event(PROFILE_PHASE_NAMES[static_cast<int>(sample.phase)], sample.thread, sample.startNs, sample.endNs - sample.startNs);
+        }
+        file << "\n]}\n";
+        return file.good();
+    }
+
+private:
+    struct Sample {
+        ProfilePhase phase;
+        std::uint8_t thread;
+        std::uint64_t startNs;
+        std::uint64_t endNs;
+    };
+
+    std::size_t retainedFrames() const {
+        return std::min<std::uint64_t>(frameCount, HISTORY);
+    }
+
+    // i = 0 is the most recent completed frame.
+    const FrameRecord& recent(std::size_t i) const {
+        return frames[(frameCount - 1 - i) % HISTORY];
+    }
+
+    static void writeHitch(std::ostream& log, const FrameRecord& frame) {
+        char line[64];
+        std::snprintf(line, sizeof(line), "hitch: frame %llu took %.2f ms (",
+            static_cast<unsigned long long>(frame.index), frame.totalNs / 1e6);
+        log << line;
+        for (int i = 0; i < PHASE_COUNT; ++i) {
+            std::snprintf(line, sizeof(line), "%s%s %.2f", i ? ", " : "", PROFILE_PHASE_NAMES[i], frame.phaseNs[i] / 1e6);
+            log << line;
+        }
+        log << ")";
+        if (frame.flags & FrameFlags::Lock) log << " lock";
+        if (frame.flags & FrameFlags::LineClear) log << " line-clear";
+        if (frame.flags & FrameFlags::BoardRedraw) log << " board-redraw";
+        if (frame.flags & FrameFlags::ChromeRedraw) log << " chrome-redraw";
+        log << "\n";
+    }
+
+    std::array<SpscQueue<Sample>, 2> samples;
+    std::vector<FrameRecord> frames;
+    std::vector<Sample> trace;
+    std::vector<std::uint64_t> scratch;
+    std::chrono::steady_clock::time_point epoch;
+    std::uint64_t hitchNs;
+    std::ostream* hitchLog = nullptr;
+
+    FrameRecord current;
+    std::atomic<std::uint8_t> pendingFlags{ 0 };
+    std::uint64_t frameCount = 0;
+    std::uint64_t traceCount = 0;
+    std::uint64_t hitchCount = 0;
+    // Counted by whichever thread's queue was full.
+    std::atomic<std::uint64_t> droppedSamples{ 0 };
+};
+
+// Times the enclosing block as one phase of the current frame.
+class ProfileScope {
+public:
+    ProfileScope(FrameProfiler& profiler, ProfilePhase phase, int thread = FrameProfiler::RENDER_THREAD)
+        : profiler(profiler), phase(phase), thread(thread), start(profiler.now()) {}
+
+    ~ProfileScope() {
+        profiler.record(phase, start, profiler.now(), thread);
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    FrameProfiler& profiler;
+    ProfilePhase phase;
+    int thread;
+    std::uint64_t start;
+};
@@ -0,0 +1,754 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include "BoardRenderer.h"
+#include "FrameProfiler.h"
+#include "ParticleSystem.h"
+#include "engine/PerfectClear.h"
+#include "engine/TetrisEngine.h"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+const int BLOCK_SIZE = 35;
+const int SIDEBAR_WIDTH = 400;
+const int SCREEN_WIDTH = GRID_WIDTH * BLOCK_SIZE + SIDEBAR_WIDTH;
+const int SCREEN_HEIGHT = GRID_HEIGHT * BLOCK_SIZE;
+
+const int MAX_SHOWN_PREVIEWS = 4;
+
+const std::array<const char*, 5> MENU_LABELS = { "Start Game", "Autoplay", "How to Play", "High Scores", "Exit" };
+
+enum class GameState {
+    Menu,
+    Playing,
+    Paused,
+    GameOver,
+    HowToPlay,
+    HighScores
+};
+
+const std::array<sf::Color, 7> COLORS = {
+    sf::Color(0, 255, 255),
+    sf::Color(0, 0, 255),
+    sf::Color(255, 165, 0),
+    sf::Color(255, 255, 0),
+    sf::Color(0, 255, 0),
+    sf::Color(255, 0, 255),
+    sf::Color(255, 0, 0)
+};
+
+const sf::Color BACKGROUND_COLOR(30, 30, 30);
+
+// One screen of the High Scores table. Names are fixed-size so copying a page
+// into a snapshot never allocates.
+struct LeaderboardPage {
+    static const int PAGE_SIZE = 10;
+    struct Row {
+        int rank;
+        std::array<char, 16> player;
+        int score;
+        int level;
+        int lines;
+    };
+    std::array<Row, PAGE_SIZE> rows{};
+    int rowCount = 0;
+    int page = 0;
+    int pageCount = 0;
+    // Bumped whenever the rows change, so the render thread rebuilds its text only then.
+    std::uint64_t revision = 0;
+};
+
+// Everything the render thread needs to draw a frame, copied out of the game by
+// the simulation thread after each update. The render thread never touches the
+// engine, so a slow present cannot hold up input or gravity.
+struct FrameSnapshot {
+    GameState state = GameState::Menu;
+    Board board;
+    std::uint64_t boardRevision = 0;
+    Piece currentPiece;
+    Piece ghostPiece;
+    sf::Vector2f pieceOffset;
+    bool hasHoldPiece = false;
+    Piece holdPiece;
+    std::array<int, MAX_SHOWN_PREVIEWS> previewTypes{};
+    int previewCount = 0;
+    int score = 0;
+    int level = 0;
+    int lines = 0;
+    int highScore = 0;
+    // Leaderboard rank (1 = best) of the game that just ended, 0 if none.
+    int lastRank = 0;
+    LeaderboardPage leaderboardPage;
+    int selectedOption = 0;
+    bool replaying = false;
+    int replaySpeed = 1;
+    bool autoplay = false;
+    bool showProfiler = false;
+    // The perfect-clear hint: the solution's placements up to its first line
+    // clear (later ones sit on a board not on screen yet) and a one-line
+    // summary, both changed only along with hintRevision.
+    bool showHint = false;
+    std::array<Piece, PerfectClearSolver::MAX_PIECES> hintPieces;
+    int hintPieceCount = 0;
+    std::array<char, 64> hintLabel{};
+    std::uint64_t hintRevision = 0;
+};
+
+// Turns FrameSnapshots into pixels: the cached chrome and board layers, the
+// batched pieces, particles, overlays and UI text. It owns everything drawn and
+// only reads the snapshot, so the game runs it on its render thread and the
+// benchmarks run it on an offscreen target with a made-up snapshot.
+class FrameRenderer {
+public:
+    explicit FrameRenderer(FrameProfiler& profiler) : profiler(profiler), mainFont(nullptr), titleFont(nullptr),
+        holdPreviewY(0.0f), nextPreviewY(0.0f), boardLayerRevision(0),
+        shownState(GameState::Menu), shownReplaySpeed(0), shownLeaderboardRevision(0) {
+        chromeStats.fill(-1);
+    }
+
+    // Builds the sprites, text and layers. The fonts and textures are used in
+    // place and must outlive the renderer.
+    void load(const sf::Font& mainFont, const sf::Font& titleFont, const sf::Texture& backgroundTexture,
+        const sf::Texture& logoTexture, const std::array<sf::Image, BoardRenderer::BLOCK_TYPES>& blockImages) {
+        this->mainFont = &mainFont;
+        this->titleFont = &titleFont;
+        boardRenderer.loadAtlas(blockImages);
+        backgroundSprite.setTexture(backgroundTexture);
+        logoSprite.setTexture(logoTexture);
+
+        float logoScale = 0.7f;
+        logoSprite.setScale(logoScale, logoScale);
+
+        sidebar.setSize(sf::Vector2f(SIDEBAR_WIDTH, SCREEN_HEIGHT));
+        sidebar.setPosition(GRID_WIDTH * BLOCK_SIZE, 0);
+        sidebar.setFillColor(sf::Color(30, 30, 30, 230));
+
+        for (const char* label : MENU_LABELS) {
+            menuOptions.push_back(createText(label, 40));
+        }
+
+        float menuY = SCREEN_HEIGHT / 2;
+        for (size_t i = 0; i < menuOptions.size(); ++i) {
+            centerText(menuOptions[i], menuY + i * 60);
+        }
+
+        prewarmGlyphs();
+        setupMenuTexts();
+        setupSidebar();
+        setupOverlayTexts();
+
+        if (!chromeLayer.create(SCREEN_WIDTH, SCREEN_HEIGHT) ||
+            !boardLayer.create(GRID_WIDTH * BLOCK_SIZE, GRID_HEIGHT * BLOCK_SIZE)) {
+            throw std::runtime_error("Failed to create render layers");
+        }
+        chromeSprite.setTexture(chromeLayer.getTexture());
+        boardSprite.setTexture(boardLayer.getTexture());
+    }
+
+    // One particle of a lock or line-clear burst, in piece color color.
+    void addParticle(const sf::Vector2f& position, int color) {
+        particles.addParticle(position, COLORS[color]);
+    }
+
+    // Render-thread side of a new snapshot: particles, animations and the UI text
+    // that depends on it.
+    void update(const FrameSnapshot& frame, float deltaTime) {
+        particles.update(deltaTime);
+
+        if (frame.state != shownState) {
+            if (frame.state == GameState::GameOver) {
+                refreshGameOverStats(frame);
+            }
+            shownState = frame.state;
+        }
+        if (frame.state == GameState::HighScores && frame.leaderboardPage.revision != shownLeaderboardRevision) {
+            refreshHighScoreTexts(frame.leaderboardPage);
+            shownLeaderboardRevision = frame.leaderboardPage.revision;
+        }
+        if (frame.showHint && frame.hintRevision != shownHintRevision) {
+            hintText.setString(frame.hintLabel.data());
+            shownHintRevision = frame.hintRevision;
+        }
+        if (frame.replaying && frame.replaySpeed != shownReplaySpeed) {
+            replayText.setString("REPLAY " + std::to_string(frame.replaySpeed) + "x");
+            shownReplaySpeed = frame.replaySpeed;
+        }
+
+        switch (frame.state) {
+        case GameState::Menu:
+            updateMenu(frame.selectedOption, deltaTime);
+            break;
+        case GameState::GameOver:
+            updateGameOver(deltaTime);
+            break;
+        default:
+            break;
+        }
+
+        if (frame.showProfiler) {
+            profilerRefreshTime -= deltaTime;
+            if (profilerRefreshTime <= 0.0f) {
+                profilerRefreshTime = 0.25f;
+                refreshProfilerText();
+            }
+        }
+        else {
+            profilerRefreshTime = 0.0f;
+        }
+    }
+
+    // Draws the frame into target; presenting it is up to the caller.
+    void draw(sf::RenderTarget& target, const FrameSnapshot& frame) {
+        target.clear(BACKGROUND_COLOR);
+
+        switch (frame.state) {
+        case GameState::Playing:
+            drawPlayfield(target, frame, true);
+            drawParticles(target);
+            if (frame.replaying) {
+                target.draw(replayText);
+            }
+            if (frame.autoplay) {
+                target.draw(autoplayText);
+            }
+            if (frame.showHint) {
+                drawHint(target, frame);
+            }
+            break;
+        case GameState::Menu:
+            target.draw(backgroundSprite);
+            renderMenu(target);
+            break;
+        case GameState::Paused:
+            drawPlayfield(target, frame, false);
+            renderPauseScreen(target);
+            break;
+        case GameState::GameOver:
+            drawPlayfield(target, frame, false);
+            renderGameOver(target);
+            break;
+        case GameState::HowToPlay:
+            target.draw(backgroundSprite);
+            renderHowToPlay(target);
+            break;
+        case GameState::HighScores:
+            target.draw(backgroundSprite);
+            renderHighScores(target);
+            break;
+        }
+
+        if (frame.showProfiler) {
+            target.draw(profilerText);
+        }
+    }
+
+private:
+    // The grid lines are one gray quad showing through the 1px gaps between cells.
+    void batchGridBackground(const Board& board) {
+        boardRenderer.addRect(0, 0, GRID_WIDTH * BLOCK_SIZE, GRID_HEIGHT * BLOCK_SIZE,
+            sf::Color(70, 70, 70));
+
+        for (int y = 0; y < GRID_HEIGHT; ++y) {
+            for (int x = 0; x < GRID_WIDTH; ++x) {
+                float cellX = static_cast<float>(x * BLOCK_SIZE + 1);
+                float cellY = static_cast<float>(y * BLOCK_SIZE + 1);
+                boardRenderer.addRect(cellX, cellY, BLOCK_SIZE - 2, BLOCK_SIZE - 2, BACKGROUND_COLOR);
+                if (board.isOccupied(x, y)) {
+                    boardRenderer.addBlock(cellX, cellY, BLOCK_SIZE - 2, board.colorAt(x, y) - 1);
+                }
+            }
+        }
+    }
+
+    void batchFallingPieces(const FrameSnapshot& frame) {
+        const Piece& piece = frame.currentPiece;
+        const sf::Color& color = COLORS[piece.type];
+        sf::Color ghostColor(color.r, color.g, color.b, 50);
+        for (const auto& block : frame.ghostPiece.getBlocks()) {
+            if (block.y >= 0) {
+                boardRenderer.addRect(block.x * BLOCK_SIZE + 1, block.y * BLOCK_SIZE + 1,
+                    BLOCK_SIZE - 2, BLOCK_SIZE - 2, ghostColor);
+            }
+        }
+
+        const sf::Vector2f& offset = frame.pieceOffset;
+        for (const auto& block : piece.getBlocks()) {
+            if (block.y >= 0) {
+                boardRenderer.addBlock(block.x * BLOCK_SIZE + 1 + offset.x, block.y * BLOCK_SIZE + 1 + offset.y,
+                    BLOCK_SIZE - 2, piece.type);
+            }
+        }
+    }
+
+    void batchPreviewPiece(int type, float x, float y, float cellSize = BLOCK_SIZE) {
+        for (const auto& cell : PIECE_SHAPES[type][0].cells) {
+            boardRenderer.addBlock(x + cell.x * cellSize, y + cell.y * cellSize,
+                cellSize - 2, type);
+        }
+    }
+
+    // The first upcoming piece is shown full size, the rest of the queue at half
+    // size in a row beside it.
+    void batchNextPieces(const FrameSnapshot& frame) {
+        const float smallCell = BLOCK_SIZE / 2.0f;
+        batchPreviewPiece(frame.previewTypes[0], GRID_WIDTH * BLOCK_SIZE + 20, nextPreviewY + 30);
+        for (int i = 1; i < frame.previewCount; ++i) {
+            batchPreviewPiece(frame.previewTypes[i],
+                GRID_WIDTH * BLOCK_SIZE + 170 + (i - 1) * (4 * smallCell + 8),
+                nextPreviewY + 30 + smallCell / 2, smallCell);
+        }
+    }
+
+    void updateLayers(const FrameSnapshot& frame) {
+        std::array<int, 4> stats = {
+            frame.score, frame.level, frame.lines, frame.highScore
+        };
+        if (stats != chromeStats) {
+            for (size_t i = 0; i < stats.size(); ++i) {
+                if (stats[i] != chromeStats[i]) {
+                    setStatValue(i, stats[i]);
+                }
+            }
+            chromeStats = stats;
+            ProfileScope scope(profiler, ProfilePhase::DrawUI);
+            profiler.flag(FrameFlags::ChromeRedraw);
+            chromeLayer.clear(BACKGROUND_COLOR);
+            drawUI(chromeLayer);
+            chromeLayer.display();
+        }
+
+        if (frame.boardRevision != boardLayerRevision) {
+            boardLayerRevision = frame.boardRevision;
+            ProfileScope scope(profiler, ProfilePhase::DrawGridBackground);
+            profiler.flag(FrameFlags::BoardRedraw);
+            boardRenderer.clear();
+            batchGridBackground(frame.board);
+            boardLayer.clear(BACKGROUND_COLOR);
+            boardRenderer.draw(boardLayer);
+            boardLayer.display();
+        }
+    }
+
+    // Composites the cached layers and batches only what moves between locks.
+    void drawPlayfield(sf::RenderTarget& target, const FrameSnapshot& frame, bool withFallingPieces) {
+        updateLayers(frame);
+        ProfileScope scope(profiler, ProfilePhase::DrawPieces);
+        target.draw(chromeSprite);
+        target.draw(boardSprite);
+
+        boardRenderer.clear();
+        if (withFallingPieces) {
+            batchFallingPieces(frame);
+        }
+        batchNextPieces(frame);
+        if (frame.hasHoldPiece) {
+            batchPreviewPiece(frame.holdPiece.type, GRID_WIDTH * BLOCK_SIZE + 20, holdPreviewY + 30);
+        }
+        boardRenderer.draw(target);
+    }
+
+    // Outlines where the hinted pieces go, the next one brightest.
+    void drawHint(sf::RenderTarget& target, const FrameSnapshot& frame) {
+        for (int i = 0; i < frame.hintPieceCount; ++i) {
+            const Piece& piece = frame.hintPieces[i];
+            const sf::Color& color = COLORS[piece.type];
+            hintCell.setOutlineColor(sf::Color(color.r, color.g, color.b, i == 0 ? 230 : 110));
+            for (const auto& block : piece.getBlocks()) {
+                hintCell.setPosition(block.x * BLOCK_SIZE + 4, block.y * BLOCK_SIZE + 4);
+                target.draw(hintCell);
+            }
+        }
+        target.draw(hintText);
+    }
+
+    void drawParticles(sf::RenderTarget& target) {
+        ProfileScope scope(profiler, ProfilePhase::Particles);
+        particles.draw(target);
+    }
+
+    void renderMenu(sf::RenderTarget& target) {
+        ProfileScope scope(profiler, ProfilePhase::Overlay);
+        target.draw(menuLogoSprite);
+        target.draw(menuCreditText);
+        target.draw(menuTitleText);
+
+        for (const auto& option : menuOptions) {
+            target.draw(option);
+        }
+    }
+
+    void renderPauseScreen(sf::RenderTarget& target) {
+        ProfileScope scope(profiler, ProfilePhase::Overlay);
+        overlay.setFillColor(sf::Color(0, 0, 0, 128));
+        target.draw(overlay);
+        target.draw(pauseText);
+        target.draw(resumeText);
+    }
+
+    void renderGameOver(sf::RenderTarget& target) {
+        ProfileScope scope(profiler, ProfilePhase::Overlay);
+        overlay.setFillColor(sf::Color(0, 0, 0, 200));
+        target.draw(overlay);
+        target.draw(gameOverText);
+        target.draw(gameOverStatsText);
+        target.draw(restartText);
+    }
+
+    void renderHowToPlay(sf::RenderTarget& target) {
+        ProfileScope scope(profiler, ProfilePhase::Overlay);
+        overlay.setFillColor(sf::Color(0, 0, 0, 230));
+        target.draw(overlay);
+        target.draw(howToPlayTitle);
+        for (const auto& text : instructionTexts) {
+            target.draw(text);
+        }
+        target.draw(backText);
+    }
+
+    void renderHighScores(sf::RenderTarget& target) {
+        ProfileScope scope(profiler, ProfilePhase::Overlay);
+        overlay.setFillColor(sf::Color(0, 0, 0, 230));
+        target.draw(overlay);
+        target.draw(highScoresTitle);
+        for (const auto& text : highScoreTexts) {
+            target.draw(text);
+        }
+        target.draw(backText);
+    }
+
+    // Background, sidebar, logo and stats; drawn into chromeLayer only when a stat changes.
+    void drawUI(sf::RenderTarget& target) {
+        target.draw(backgroundSprite);
+        target.draw(sidebar);
+        target.draw(logoSprite);
+        target.draw(sidebarCreditText);
+        for (size_t i = 0; i < statLabelTexts.size(); ++i) {
+            target.draw(statLabelTexts[i]);
+            target.draw(statValueTexts[i]);
+        }
+        target.draw(holdLabelText);
+        target.draw(nextLabelText);
+    }
+
+    void updateMenu(int selectedOption, float deltaTime) {
+        menuPulse += deltaTime * 2;
+
+        for (size_t i = 0; i < menuOptions.size(); ++i) {
+            if (i == static_cast<size_t>(selectedOption)) {
+                float pulse = (std::sin(menuPulse) + 1) / 2;
+                menuOptions[i].setFillColor(sf::Color(255, 255, 0,
+                    static_cast<sf::Uint8>(155 + 100 * pulse)));
+                menuOptions[i].setScale(1.1f, 1.1f);
+            }
+            else {
+                menuOptions[i].setFillColor(sf::Color::White);
+                menuOptions[i].setScale(1.0f, 1.0f);
+            }
+        }
+    }
+
+    void updateGameOver(float deltaTime) {
+        gameOverPulse += deltaTime * 2;
+        gameOverText.setFillColor(sf::Color(255, 0, 0,
+            static_cast<sf::Uint8>(155 + 100 * ((std::sin(gameOverPulse) + 1) / 2))));
+    }
+
+    void refreshProfilerText() {
+        char line[96];
+        std::snprintf(line, sizeof(line), "frame ms  p50 %.2f  p95 %.2f  p99 %.2f  max %.2f\nhitches %llu\n",
+            profiler.percentileMs(50), profiler.percentileMs(95), profiler.percentileMs(99), profiler.percentileMs(100),
+            static_cast<unsigned long long>(profiler.getHitchCount()));
+        std::string text = line;
+        for (int i = 0; i < FrameProfiler::PHASE_COUNT; ++i) {
+            std::snprintf(line, sizeof(line), "%-20s %.3f ms\n", PROFILE_PHASE_NAMES[i],
+                profiler.phaseMeanMs(static_cast<ProfilePhase>(i)));
+            text += line;
+        }
+        profilerText.setString(text);
+    }
+
+    // Called when the page on show changes rather than on every frame it is shown.
+    void refreshHighScoreTexts(const LeaderboardPage& page) {
+        // Player names are left-aligned at their x, the numbers right-aligned.
+        const std::array<float, 5> columnX = { 110, 140, 480, 570, 660 };
+        const int nameColumn = 1;
+        highScoreTexts.clear();
+        auto addCell = [&](const std::string& content, int column, float y, sf::Color color) {
+            sf::Text text = createText(content, 25);
+            text.setFillColor(color);
+            text.setOrigin(column == nameColumn ? 0 : text.getLocalBounds().width, 0);
+            text.setPosition(columnX[column], y);
+            highScoreTexts.push_back(text);
+        };
+
+        float y = SCREEN_HEIGHT * 0.25f;
+        const std::array<const char*, 5> headers = { "#", "PLAYER", "SCORE", "LEVEL", "LINES" };
+        for (int column = 0; column < 5; ++column) {
+            addCell(headers[column], column, y, sf::Color::Yellow);
+        }
+        for (int i = 0; i < page.rowCount; ++i) {
+            const LeaderboardPage::Row& row = page.rows[i];
+            y += 40;
+            addCell(std::to_string(row.rank) + ".", 0, y, sf::Color::White);
+            addCell(row.player.data(), 1, y, sf::Color::White);
+            addCell(std::to_string(row.score), 2, y, sf::Color::White);
+            addCell(std::to_string(row.level), 3, y, sf::Color::White);
+            addCell(std::to_string(row.lines), 4, y, sf::Color::White);
+        }
+
+        std::string footer = page.rowCount == 0 ? "No scores yet" :
+            "Page " + std::to_string(page.page + 1) + " / " + std::to_string(page.pageCount) + "    LEFT / RIGHT to turn";
+        highScoreTexts.push_back(createText(footer, 20));
+        centerText(highScoreTexts.back(), SCREEN_HEIGHT * 0.85f);
+    }
+
+    // Rasterizes every printable ASCII glyph at the sizes the UI uses, so the first
+    // frame showing a size (notably the 150pt title) does not stall on the font.
+    void prewarmGlyphs() {
+        const unsigned int mainSizes[] = { 20, 24, 25, 30, 36, 40 };
+        const unsigned int titleSizes[] = { 50, 60, 70 };
+        for (sf::Uint32 c = 32; c < 127; ++c) {
+            for (unsigned int size : mainSizes) {
+                mainFont->getGlyph(c, size, false);
+            }
+            for (unsigned int size : titleSizes) {
+                titleFont->getGlyph(c, size, false);
+            }
+            titleFont->getGlyph(c, 150, true);
+        }
+    }
+
+    void setupMenuTexts() {
+        menuLogoSprite = logoSprite;
+        menuLogoSprite.setPosition(
+            (SCREEN_WIDTH - menuLogoSprite.getGlobalBounds().width) / 2,
+            20
+        );
+
+        menuCreditText = createText("Made by Najaf Ali", 36);
+        menuCreditText.setPosition(
+            (SCREEN_WIDTH - menuCreditText.getGlobalBounds().width) / 2,
+            menuLogoSprite.getPosition().y + menuLogoSprite.getGlobalBounds().height + 14
+        );
+
+        menuTitleText = createText("TETRIS", 150, *titleFont);
+        menuTitleText.setStyle(sf::Text::Bold);
+        centerText(menuTitleText, SCREEN_HEIGHT * 0.34f);
+        menuTitleText.setFillColor(sf::Color::Yellow);
+    }
+
+    void setupSidebar() {
+        float sidebarCenterX = GRID_WIDTH * BLOCK_SIZE + (SIDEBAR_WIDTH / 2);
+
+        logoSprite.setPosition(
+            sidebarCenterX - (logoSprite.getGlobalBounds().width / 2),
+            20
+        );
+
+        sidebarCreditText = createText("Made By Najaf Ali", 24);
+        sf::FloatRect creditBounds = sidebarCreditText.getLocalBounds();
+        sidebarCreditText.setOrigin(creditBounds.width / 2, creditBounds.height / 2);
+        sidebarCreditText.setPosition(
+            sidebarCenterX,
+            logoSprite.getPosition().y + logoSprite.getGlobalBounds().height + 20
+        );
+
+        const char* labels[] = { "SCORE", "LEVEL", "LINES", "HIGH SCORE" };
+        float startY = sidebarCreditText.getPosition().y + sidebarCreditText.getGlobalBounds().height + 40;
+        for (size_t i = 0; i < statLabelTexts.size(); ++i) {
+            statLabelTexts[i] = createText(labels[i], 20);
+            sf::FloatRect labelBounds = statLabelTexts[i].getLocalBounds();
+            statLabelTexts[i].setOrigin(labelBounds.width / 2, labelBounds.height / 2);
+            statLabelTexts[i].setPosition(sidebarCenterX, startY);
+            statLabelTexts[i].setFillColor(sf::Color(200, 200, 200));
+
+            statValueTexts[i] = createText("", 30);
+            statValueTexts[i].setPosition(sidebarCenterX, startY + 25);
+            startY += 80;
+        }
+
+        holdPreviewY = startY;
+        nextPreviewY = startY + 120;
+        holdLabelText = createText("HOLD", 20);
+        holdLabelText.setPosition(GRID_WIDTH * BLOCK_SIZE + 20, holdPreviewY);
+        holdLabelText.setFillColor(sf::Color(200, 200, 200));
+        nextLabelText = createText("NEXT", 20);
+        nextLabelText.setPosition(GRID_WIDTH * BLOCK_SIZE + 20, nextPreviewY);
+        nextLabelText.setFillColor(sf::Color(200, 200, 200));
+    }
+
+    void setupOverlayTexts() {
+        overlay.setSize(sf::Vector2f(SCREEN_WIDTH, SCREEN_HEIGHT));
+
+        howToPlayTitle = createText("HOW TO PLAY", 50, *titleFont);
+        centerText(howToPlayTitle, SCREEN_HEIGHT * 0.15f);
+        howToPlayTitle.setFillColor(sf::Color::Yellow);
+
+        const char* instructions[] = {
+            "CONTROLS:",
+            "Arrow keys Left/Right      Move piece left/right",
+            "Arrow key Up      Rotate piece",
+            "Arrow key Down      Soft drop",
+            "C :     Hold piece",
+            "H :     Perfect-clear hint",
+            "ESC :     Pause game",
+            "",
+            "SCORING:",
+            "1 line: 100      level",
+            "2 lines: 300     level",
+            "3 lines: 500     level",
+            "4 lines: 800     level"
+        };
+        float startY = SCREEN_HEIGHT * 0.3f;
+        for (const char* line : instructions) {
+            instructionTexts.push_back(createText(line, 25));
+            centerText(instructionTexts.back(), startY);
+            startY += 35;
+        }
+
+        highScoresTitle = createText("HIGH SCORES", 50, *titleFont);
+        centerText(highScoresTitle, SCREEN_HEIGHT * 0.15f);
+        highScoresTitle.setFillColor(sf::Color::Yellow);
+
+        backText = createText("Press ESC to return", 20);
+        centerText(backText, SCREEN_HEIGHT * 0.9f);
+
+        pauseText = createText("PAUSED", 60, *titleFont);
+        centerText(pauseText, SCREEN_HEIGHT / 2);
+        resumeText = createText("Press ESC to resume", 30);
+        centerText(resumeText, SCREEN_HEIGHT / 2 + 80);
+
+        profilerText = createText("", 14);
+        profilerText.setPosition(10, 40);
+        profilerText.setFillColor(sf::Color::Green);
+        profilerText.setOutlineColor(sf::Color::Black);
+        profilerText.setOutlineThickness(1.0f);
+
+        replayText = createText("", 20);
+        replayText.setPosition(10, 10);
+        replayText.setFillColor(sf::Color::Yellow);
+        autoplayText = createText("AUTOPLAY", 20);
+        autoplayText.setPosition(10, 10);
+        autoplayText.setFillColor(sf::Color::Yellow);
+        hintText = createText("", 18);
+        hintText.setPosition(10, SCREEN_HEIGHT - 30);
+        hintText.setFillColor(sf::Color::White);
+        hintText.setOutlineColor(sf::Color::Black);
+        hintText.setOutlineThickness(1.0f);
+        hintCell.setSize(sf::Vector2f(BLOCK_SIZE - 8, BLOCK_SIZE - 8));
+        hintCell.setFillColor(sf::Color::Transparent);
+        hintCell.setOutlineThickness(3.0f);
+
+        gameOverText = createText("GAME OVER", 70, *titleFont);
+        centerText(gameOverText, SCREEN_HEIGHT * 0.3f);
+        gameOverText.setFillColor(sf::Color::Red);
+        restartText = createText("Press SPACE to restart\nPress ESC to return to menu", 25);
+        centerText(restartText, SCREEN_HEIGHT * 0.7f);
+    }
+
+    void setStatValue(size_t index, int value) {
+        sf::Text& text = statValueTexts[index];
+        text.setString(std::to_string(value));
+        sf::FloatRect bounds = text.getLocalBounds();
+        text.setOrigin(bounds.width / 2, bounds.height / 2);
+    }
+
+    void refreshGameOverStats(const FrameSnapshot& frame) {
+        std::stringstream ss;
+        ss << "Final Score: " << frame.score << "\n";
+        ss << "High Score: " << frame.highScore << "\n";
+        if (frame.lastRank > 0) {
+            ss << "Rank: #" << frame.lastRank << "\n";
+        }
+        ss << "Lines Cleared: " << frame.lines << "\n";
+        ss << "Level Reached: " << frame.level;
+        gameOverStatsText = createText(ss.str(), 30);
+        centerText(gameOverStatsText, SCREEN_HEIGHT * 0.5f);
+    }
+
+    sf::Text createText(const std::string& content, unsigned int size) {
+        return createText(content, size, *mainFont);
+    }
+
+    sf::Text createText(const std::string& content, unsigned int size, const sf::Font& font) {
+        sf::Text text;
+        text.setFont(font);
+        text.setString(content);
+        text.setCharacterSize(size);
+        text.setFillColor(sf::Color::White);
+        return text;
+    }
+
+    void centerText(sf::Text& text, float y) {
+        sf::FloatRect bounds = text.getLocalBounds();
+        text.setOrigin(bounds.width / 2, bounds.height / 2);
+        text.setPosition(SCREEN_WIDTH / 2, y);
+    }
+
+    FrameProfiler& profiler;
+    const sf::Font* mainFont;
+    const sf::Font* titleFont;
+    BoardRenderer boardRenderer;
+    ParticleSystem particles;
+    sf::Sprite backgroundSprite;
+    sf::Sprite logoSprite;
+    float holdPreviewY;
+    float nextPreviewY;
+
+    // Pre-rendered layers. chromeLayer is redrawn when a sidebar stat changes,
+    // boardLayer (grid and locked blocks) when the engine's board revision does.
+    sf::RenderTexture chromeLayer;
+    sf::RenderTexture boardLayer;
+    sf::Sprite chromeSprite;
+    sf::Sprite boardSprite;
+    std::array<int, 4> chromeStats;
+    std::uint64_t boardLayerRevision;
+
+    sf::RectangleShape sidebar;
+    std::vector<sf::Text> menuOptions;
+    float menuPulse = 0.0f;
+    float gameOverPulse = 0.0f;
+
+    // UI text is built once in load(); afterwards only the strings of values
+    // that actually changed are replaced, so steady frames do not allocate.
+    sf::Sprite menuLogoSprite;
+    sf::Text menuCreditText;
+    sf::Text menuTitleText;
+    sf::Text sidebarCreditText;
+    std::array<sf::Text, 4> statLabelTexts;
+    std::array<sf::Text, 4> statValueTexts;
+    sf::Text holdLabelText;
+    sf::Text nextLabelText;
+    sf::Text howToPlayTitle;
+    std::vector<sf::Text> instructionTexts;
+    sf::Text highScoresTitle;
+    std::vector<sf::Text> highScoreTexts;
+    sf::Text backText;
+    sf::Text pauseText;
+    sf::Text resumeText;
+    sf::Text gameOverText;
+    sf::Text gameOverStatsText;
+    sf::Text restartText;
+    sf::Text replayText;
+    sf::Text autoplayText;
+    sf::Text hintText;
+    // Outline drawn on each cell of a hinted placement.
+    sf::RectangleShape hintCell;
+    sf::RectangleShape overlay;
+    // What the UI text currently shows, so it is rebuilt only when that changes.
+    GameState shownState;
+    int shownReplaySpeed;
+    std::uint64_t shownLeaderboardRevision;
+    std::uint64_t shownHintRevision = 0;
+
+    // The profiler overlay's text is refreshed a few times a second.
+    float profilerRefreshTime = 0.0f;
+    sf::Text profilerText;
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <SFML/System.hpp>
+#include <SFML/Window.hpp>
+#include "engine/SpscQueue.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+enum class GameKey : std::uint8_t {
+    Left,
+    Right,
+    SoftDrop,
+    Rotate,
+    HardDrop,
+    Hold,
+    Count
+};
+
+const std::array<sf::Keyboard::Key, static_cast<int>(GameKey::Count)> GAME_KEY_BINDINGS = {
+    sf::Keyboard::Left, sf::Keyboard::Right, sf::Keyboard::Down,
+    sf::Keyboard::Up, sf::Keyboard::Space, sf::Keyboard::C
+};
+
+struct KeyEvent {
+    GameKey key;
+    bool pressed;
+    // Seconds on InputThread::now()'s clock.
+    double time;
+};
+
+// Samples the gameplay keys on a dedicated thread (1000 Hz by default) and
+// passes each press and release, stamped with when it was seen, to the game
+// thread through a lock-free queue. This keeps OS key-repeat and the frame rate
+// out of input timing. Keys read as released while the window is unfocused.
+class InputThread {
+public:
+    explicit InputThread(int pollRate = 1000) : queue(256), pollRate(pollRate) {}
+
+    ~InputThread() {
+        stop();
+    }
+
+    InputThread(const InputThread&) = delete;
+    InputThread& operator=(const InputThread&) = delete;
+
+    // One clock for key timestamps and the game's own reads of the time.
+    static double now() {
+        static const auto epoch = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    void start() {
+        if (running.exchange(true)) return;
+        thread = std::thread(&InputThread::run, this);
+    }
+
+    void stop() {
+        if (!running.exchange(false)) return;
+        thread.join();
+    }
+
+    bool isRunning() const {
+        return running.load();
+    }
+
+    void setFocused(bool focused) {
+        this->focused.store(focused);
+    }
+
+    // Called from the game thread only.
+    bool poll(KeyEvent& event) {
+        return queue.tryPop(event);
+    }
+
+private:
+    void run() {
+        std::array<bool, static_cast<int>(GameKey::Count)> held{};
+        sf::Time interval = sf::microseconds(1000000 / pollRate);
+        while (running.load(std::memory_order_relaxed)) {
+            bool focused = this->focused.load(std::memory_order_relaxed);
+            double time = now();
+            for (std::size_t i = 0; i < held.size(); ++i) {
+                bool pressed = focused && sf::Keyboard::isKeyPressed(GAME_KEY_BINDINGS[i]);
+                // A full queue means the game is not draining it (e.g. loading); the
+                // edge is retried on the next sample.
+                if (pressed != held[i] && queue.tryPush(KeyEvent{ static_cast<GameKey>(i), pressed, time })) {
+                    held[i] = pressed;
+                }
+            }
+            // sf::sleep raises the Windows timer resolution, unlike std::this_thread::sleep_for.
+            sf::sleep(interval);
+        }
+    }
+
+    SpscQueue<KeyEvent> queue;
+    int pollRate;
+    std::atomic<bool> running{ false };
+    std::atomic<bool> focused{ true };
+    std::thread thread;
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fixed-capacity particle pool stored as structure-of-arrays. Dead particles are
+// swap-removed, and the vertex for each live particle is updated in place, so
+// neither update() nor draw() allocates once the pool is constructed. Velocities
+// come from the pool's own generator rather than the global rand() stream.
+class ParticleSystem {
+public:
+    explicit ParticleSystem(std::size_t capacity = 65536, float lifetime = 1.0f, std::uint32_t seed = 0x9E3779B9u)
+        : positionX(capacity), positionY(capacity), velocityX(capacity), velocityY(capacity),
+        remaining(capacity), vertices(capacity), count(0), lifetime(lifetime), rngState(seed ? seed : 1) {}
+
+    // Returns false (and drops the particle) when the pool is full.
+    bool addParticle(const sf::Vector2f& position, const sf::Color& color) {
+        if (count == remaining.size()) return false;
+
+        std::size_t i = count++;
+        positionX[i] = position.x;
+        positionY[i] = position.y;
+        velocityX[i] = randomVelocity();
+        velocityY[i] = randomVelocity();
+        remaining[i] = lifetime;
+        vertices[i] = sf::Vertex(position, color);
+        return true;
+    }
+
+    void update(float deltaTime) {
+        // Branch-free integration over contiguous arrays so the compiler can vectorize it.
+        float* x = positionX.data();
+        float* y = positionY.data();
+        const float* vx = velocityX.data();
+        const float* vy = velocityY.data();
+        float* life = remaining.data();
+        for (std::size_t i = 0; i < count; ++i) {
+            life[i] -= deltaTime;
+            x[i] += vx[i] * deltaTime;
+            y[i] += vy[i] * deltaTime;
+        }
+
+        float alphaScale = 255.0f / lifetime;
+        for (std::size_t i = 0; i < count;) {
+            if (life[i] <= 0) {
+                removeAt(i);
+                continue;
+            }
+            vertices[i].position.x = x[i];
+            vertices[i].position.y = y[i];
+            vertices[i].color.a = static_cast<sf::Uint8>(life[i] * alphaScale);
+            ++i;
+        }
+    }
+
+    void draw(sf::RenderTarget& target) const {
+        if (count > 0) {
+            target.draw(vertices.data(), count, sf::Points);
+        }
+    }
+
+    void clear() {
+        count = 0;
+    }
+
+    std::size_t size() const {
+        return count;
+    }
+
+    std::size_t capacity() const {
+        return remaining.size();
+    }
+
+private:
+    void removeAt(std::size_t i) {
+        std::size_t last = --count;
+        positionX[i] = positionX[last];
+        positionY[i] = positionY[last];
+        velocityX[i] = velocityX[last];
+        velocityY[i] = velocityY[last];
+        remaining[i] = remaining[last];
+        vertices[i] = vertices[last];
+    }
+
+    // xorshift32, mapped to the same [-10, 10) px/s range the particles always used.
+    float randomVelocity() {
+        rngState ^= rngState << 13;
+        rngState ^= rngState >> 17;
+        rngState ^= rngState << 5;
+        return (rngState >> 8) * (20.0f / 16777216.0f) - 10.0f;
+    }
+
+    std::vector<float> positionX;
+    std::vector<float> positionY;
+    std::vector<float> velocityX;
+    std::vector<float> velocityY;
+    std::vector<float> remaining;
+    std::vector<sf::Vertex> vertices;
+    std::size_t count;
+    float lifetime;
+    std::uint32_t rngState;
+};
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <SFML/Audio.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// An asset's raw bytes: either a view into a resource pack mapping or, for a
+// loose file, a copy held in storage.
+struct AssetBytes {
+    const void* data = nullptr;
+    std::size_t size = 0;
+    std::vector<char> storage;
+};
+
+// Audio decoded to PCM, ready to hand to an sf::SoundBuffer.
+struct DecodedSound {
+    std::vector<sf::Int16> samples;
+    unsigned int channelCount = 0;
+    unsigned int sampleRate = 0;
+
+    bool decode(const AssetBytes& bytes) {
+        sf::InputSoundFile file;
+        if (!file.openFromMemory(bytes.data, bytes.size)) return false;
+        samples.resize(static_cast<std::size_t>(file.getSampleCount()));
+        channelCount = file.getChannelCount();
+        sampleRate = file.getSampleRate();
+        return file.read(samples.data(), samples.size()) == samples.size();
+    }
+
+    bool loadInto(sf::SoundBuffer& buffer) const {
+        return buffer.loadFromSamples(samples.data(), samples.size(), channelCount, sampleRate);
+    }
+};
+
+// Loads a set of assets concurrently. Each asset's decode step (file reads,
+// image and audio decoding) runs on a worker thread of its own; its optional
+// finish step runs on the thread calling poll(), for work that has to happen
+// there, such as uploading a texture on the thread that owns the GL context.
+// All assets must be added before start().
+class ResourceLoader {
+public:
+    using Step = std::function<bool(const std::string& path)>;
+
+    void add(const std::string& path, Step decode, Step finish = nullptr) {
+        assets.push_back(Asset{ path, std::move(decode), std::move(finish) });
+    }
+
+    void start() {
+        startTime = Clock::now();
+        for (Asset& asset : assets) {
+            asset.result = std::async(std::launch::async, [&asset] {
+                Clock::time_point start = Clock::now();
+                bool loaded = asset.decode(asset.path);
+                return loaded ? millisecondsSince(start) : -1.0;
+            });
+        }
+    }
+
+    // Finishes every asset whose decode has completed. Returns true once all are
+    // loaded; throws if any fails.
+    bool poll() {
+        for (Asset& asset : assets) {
+            if (asset.done || asset.result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                continue;
+            }
+            asset.decodeMs = asset.result.get();
+            Clock::time_point start = Clock::now();
+            if (asset.decodeMs < 0.0 || (asset.finish && !asset.finish(asset.path))) {
+                throw std::runtime_error("Failed to load " + asset.path);
+            }
+            asset.finishMs = millisecondsSince(start);
+            asset.done = true;
+            loadedCount++;
+        }
+        if (loadedCount == assets.size() && totalMs == 0.0) {
+            totalMs = millisecondsSince(startTime);
+        }
+        return loadedCount == assets.size();
+    }
+
+    std::size_t getLoadedCount() const { return loadedCount; }
+    std::size_t getAssetCount() const { return assets.size(); }
+
+    // Slowest assets first, then the wall time for the whole set.
+    void report(std::ostream& out) const {
+        std::vector<const Asset*> sorted;
+        for (const Asset& asset : assets) {
+            sorted.push_back(&asset);
+        }
+        std::sort(sorted.begin(), sorted.end(), [](const Asset* a, const Asset* b) {
+            return a->decodeMs + a->finishMs > b->decodeMs + b->finishMs;
+        });
+        char line[160];
+        for (const Asset* asset : sorted) {
+            std::snprintf(line, sizeof(line), "load %-36s decode %8.2f ms  finish %8.2f ms\n",
+                asset->path.c_str(), asset->decodeMs, asset->finishMs);
+            out << line;
+        }
+        std::snprintf(line, sizeof(line), "loaded %zu assets in %.2f ms\n", assets.size(), totalMs);
+        out << line;
+    }
+
+    static bool readFile(const std::string& path, AssetBytes& bytes) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) return false;
+        bytes.storage.resize(static_cast<std::size_t>(file.tellg()));
+        file.seekg(0);
+        bytes.data = bytes.storage.data();
+        bytes.size = bytes.storage.size();
+        return static_cast<bool>(file.read(bytes.storage.data(), bytes.storage.size()));
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Asset {
+        std::string path;
+        Step decode;
+        Step finish;
+        std::future<double> result;
+        double decodeMs = 0.0;
+        double finishMs = 0.0;
+        bool done = false;
+    };
+
+    static double millisecondsSince(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    std::vector<Asset> assets;
+    std::size_t loadedCount = 0;
+    Clock::time_point startTime;
+    double totalMs = 0.0;
+};
@@ -0,0 +1,398 @@
+// Microbenchmarks for the engine, move generator, bot, perfect-clear solver,
+// leaderboard and render hot paths.
+//
+//   Benchmarks [--filter SUBSTRING] [--min-time SECONDS]
+//
+// Prints one CSV row per benchmark (name, iterations, ns/op, allocations/op) so
+// results can be diffed between builds or checked against a threshold. Engine
+// operations that change state run on a fresh copy of a prepared engine each
+// iteration; the engine_copy and board_copy rows give that baseline.
+#define TETRIS_COUNT_ALLOCATIONS
+#include "../AllocationCounter.h"
+#include "../FrameRenderer.h"
+#include "../ParticleSystem.h"
+#include "../engine/Bot.h"
+#include "../engine/Leaderboard.h"
+#include "../engine/MoveGenerator.h"
+#include "../engine/PerfectClear.h"
+#include "../engine/TetrisEngine.h"
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+    std::string filter;
+    double minSeconds = 0.25;
+    volatile std::uint64_t sink;
+
+    // Doubles the iteration count until one timed batch lasts at least minSeconds.
+    template <typename Op>
+    void run(const std::string& name, Op op) {
+        if (!filter.empty() && name.find(filter) == std::string::npos) return;
+
+        for (int i = 0; i < 100; ++i) {
+            sink += static_cast<std::uint64_t>(op());
+        }
+
+        for (std::uint64_t iterations = 64;; iterations *= 2) {
+            std::uint64_t allocationsBefore = AllocationCounter::count();
+            auto start = std::chrono::steady_clock::now();
+            for (std::uint64_t i = 0; i < iterations; ++i) {
+                sink += static_cast<std::uint64_t>(op());
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::uint64_t allocations = AllocationCounter::count() - allocationsBefore;
+
+            if (seconds >= minSeconds || iterations >= (1ull << 32)) {
+                std::printf("%s,%llu,%.2f,%.3f\n", name.c_str(), static_cast<unsigned long long>(iterations),
+                    seconds * 1e9 / iterations, static_cast<double>(allocations) / iterations);
+                std::fflush(stdout);
+                return;
+            }
+        }
+    }
+
+    struct NamedBoard {
+        const char* name;
+        Board board;
+    };
+
+    Board fillColumns(const std::array<int, GRID_WIDTH>& heights, bool holes) {
+        Board board;
+        board.clear();
+        for (int x = 0; x < GRID_WIDTH; ++x) {
+            for (int h = 0; h < heights[x]; ++h) {
+                if (holes && (x + h) % 5 == 0) continue;
+                board.setCell(x, GRID_HEIGHT - 1 - h, 1 + (x + h) % PIECE_TYPES);
+            }
+        }
+        return board;
+    }
+
+    // The bottom four rows are full except for the column a vertical I piece
+    // dropped from the spawn point lands in.
+    Board tetrisBoard(int wellColumn) {
+        std::array<int, GRID_WIDTH> heights;
+        heights.fill(4);
+        heights[wellColumn] = 0;
+        return fillColumns(heights, false);
+    }
+
+    std::vector<NamedBoard> syntheticBoards(int wellColumn) {
+        Board empty;
+        empty.clear();
+        return {
+            { "empty", empty },
+            { "ragged", fillColumns({ 3, 7, 2, 9, 5, 1, 8, 4, 6, 0 }, true) },
+            { "near_top", fillColumns({ 19, 20, 18, 20, 17, 0, 19, 20, 18, 19 }, true) },
+            { "tetris", tetrisBoard(wellColumn) },
+        };
+    }
+
+    // An engine whose current piece is a vertical I, so hard-dropping it into the
+    // tetris board's well clears four rows.
+    TetrisEngine engineWithVerticalI() {
+        TetrisEngine engine;
+        for (std::uint64_t seed = 0; engine.getCurrentPiece().type != 0; ++seed) {
+            engine.reset(seed);
+        }
+        engine.applyInput(Input::Rotate);
+        return engine;
+    }
+
+    // Valid placements of every type and rotation near the top of the board.
+    std::vector<Piece> samplePieces(const Board& board) {
+        std::vector<Piece> pieces;
+        for (int type = 0; type < PIECE_TYPES; ++type) {
+            for (int rotation = 0; rotation < ROTATION_COUNTS[type]; ++rotation) {
+                for (int x = 0; x < GRID_WIDTH; ++x) {
+                    Piece piece(type);
+                    piece.rotation = rotation;
+                    piece.x = x;
+                    if (isValidPosition(piece, board)) {
+                        pieces.push_back(piece);
+                    }
+                }
+            }
+        }
+        return pieces;
+    }
+
+    void benchEngine() {
+        TetrisEngine base = engineWithVerticalI();
+        int wellColumn = base.getCurrentPiece().x;
+
+        for (const auto& named : syntheticBoards(wellColumn)) {
+            const std::string suffix = std::string("/") + named.name;
+            const Board& board = named.board;
+
+            std::vector<Piece> pieces = samplePieces(board);
+            std::size_t next = 0;
+            run("isValidPosition" + suffix, [&] {
+                const Piece& piece = pieces[next++ % pieces.size()];
+                return isValidPosition(piece, board) ? 1 : 0;
+            });
+            run("Piece::getBlocks" + suffix, [&] {
+                return pieces[next++ % pieces.size()].getBlocks()[3].y;
+            });
+            run("dropDistance" + suffix, [&] {
+                return dropDistance(pieces[next++ % pieces.size()], board);
+            });
+
+            TetrisEngine prepared = base;
+            prepared.loadBoard(board);
+            run("updateGhostPiece" + suffix, [&] {
+                return prepared.getGhostPiece().y;
+            });
+            run("engine_copy" + suffix, [&] {
+                TetrisEngine engine = prepared;
+                return engine.getCurrentPiece().y;
+            });
+            run("hardDrop" + suffix, [&] {
+                TetrisEngine engine = prepared;
+                return engine.applyInput(Input::HardDrop).lineClear.count;
+            });
+
+            // A piece already resting on the stack, so the gravity tick goes straight to lockPiece.
+            TetrisEngine landed = prepared;
+            while (landed.applyInput(Input::SoftDrop).moved) {
+            }
+            run("lockPiece" + suffix, [&] {
+                TetrisEngine engine = landed;
+                return engine.applyGravity().lineClear.count;
+            });
+
+            // Every piece type from its spawn position, as a bot would search each new piece.
+            MoveGenerator generator;
+            std::vector<Placement> placements;
+            int type = 0;
+            run("MoveGenerator::generate" + suffix, [&] {
+                placements.clear();
+                Piece piece(type++ % PIECE_TYPES);
+                generator.generate(board, piece, placements);
+                return placements.size();
+            });
+
+            int firstRow = landed.getGhostPiece().y;
+            int lastRow = firstRow + landed.getCurrentPiece().shape().height - 1;
+            run("board_copy" + suffix, [&] {
+                Board copy = board;
+                return copy.heights[0];
+            });
+            run("checkRows" + suffix, [&] {
+                Board copy = board;
+                return copy.clearFullRows(firstRow, lastRow).count;
+            });
+        }
+    }
+
+    void benchParticles() {
+        const std::size_t populations[] = { 1000, 10000, 65536 };
+        for (std::size_t population : populations) {
+            // A lifetime no run reaches keeps the population constant.
+            ParticleSystem particles(population, 1e9f);
+            for (std::size_t i = 0; i < population; ++i) {
+                particles.addParticle(sf::Vector2f(static_cast<float>(i % 350), static_cast<float>(i % 875)), sf::Color::Cyan);
+            }
+            run("ParticleSystem::update/" + std::to_string(population), [&] {
+                particles.update(1.0f / 60.0f);
+                return particles.size();
+            });
+        }
+    }
+
+    // One bot decision on a ragged board, greedy and with one preview piece of
+    // lookahead, on the calling thread and on a thread pool.
+    void benchBot() {
+        TetrisEngine engine;
+        engine.loadBoard(fillColumns({ 3, 7, 2, 9, 5, 1, 8, 4, 6, 0 }, true));
+        ThreadPool pool;
+        BotMove move;
+        for (int lookahead = 0; lookahead <= 1; ++lookahead) {
+            BotConfig config;
+            config.lookahead = lookahead;
+            Bot serial(config);
+            Bot parallel(config, &pool);
+            const std::string suffix = "/lookahead" + std::to_string(lookahead);
+            run("Bot::chooseMove" + suffix, [&] {
+                return serial.chooseMove(engine, move) ? move.inputs.size() : 0;
+            });
+            run("Bot::chooseMove" + suffix + "/pool" + std::to_string(pool.size() + 1), [&] {
+                return parallel.chooseMove(engine, move) ? move.inputs.size() : 0;
+            });
+        }
+    }
+
+    // A five-piece perfect clear from an empty board (with O held), searched
+    // from scratch each time (cold) and again with the transposition table the
+    // previous search left (warm), on the calling thread and on a thread pool.
+    void benchPerfectClear() {
+        const std::vector<int> queue = { 1, 4, 0, 3, 2, 5, 6 };
+        const int hold = 3;
+        Board board;
+        ThreadPool pool;
+        PerfectClearSolver serial;
+        PerfectClearSolver parallel(PerfectClearConfig(), &pool);
+        run("PerfectClearSolver::solve/cold", [&] {
+            serial.clearTable();
+            return serial.solve(board, queue, hold, true).steps.size();
+        });
+        run("PerfectClearSolver::solve/cold/pool" + std::to_string(pool.size() + 1), [&] {
+            parallel.clearTable();
+            return parallel.solve(board, queue, hold, true).steps.size();
+        });
+        run("PerfectClearSolver::solve/warm", [&] {
+            return serial.solve(board, queue, hold, true).steps.size();
+        });
+    }
+
+    // Queries on a million-record board, kept in memory so the disk stays out of
+    // the numbers. Records go in best first, which appends to every ranking.
+    void benchLeaderboard() {
+        const int recordCount = 1000000;
+        const int playerCount = 10000;
+        Leaderboard leaderboard;
+        LeaderboardRecord record;
+        for (int i = 0; i < recordCount; ++i) {
+            record.player = "player" + std::to_string(i % playerCount);
+            record.score = recordCount - i;
+            leaderboard.add(record);
+        }
+
+        std::vector<std::uint32_t> ids;
+        std::uint32_t step = 0;
+        run("leaderboard/top_page", [&] {
+            leaderboard.top(0, (step++ * 7919) % recordCount, 10, ids);
+            return ids.size();
+        });
+        run("leaderboard/rankOfScore", [&] {
+            return leaderboard.rankOfScore(0, static_cast<std::int32_t>((step++ * 7919) % recordCount));
+        });
+        run("leaderboard/rankOf", [&] {
+            return leaderboard.rankOf((step++ * 7919) % recordCount);
+        });
+        run("leaderboard/playerRecords", [&] {
+            leaderboard.playerRecords("player" + std::to_string(step++ % playerCount), 0, ids);
+            return ids.size();
+        });
+        record.player = "newcomer";
+        run("leaderboard/add", [&] {
+            record.score = static_cast<std::int32_t>((step++ * 7919) % recordCount);
+            return leaderboard.add(record);
+        });
+    }
+
+    // The game's FrameRenderer drawing a mid-game snapshot offscreen, one frame
+    // per iteration between the profiler's beginFrame and endFrame as the render
+    // loop does: steady frames, frames after a lock (board layer redrawn) and
+    // frames after a score change (sidebar layer redrawn too). The game's fonts
+    // are used when run from the repository root; otherwise the text is empty.
+    void benchFrame() {
+        sf::RenderTexture target;
+        if (!target.create(SCREEN_WIDTH, SCREEN_HEIGHT)) {
+            std::cerr << "Skipping render benchmarks: no offscreen render target available\n";
+            return;
+        }
+
+        sf::Font mainFont;
+        sf::Font titleFont;
+        mainFont.loadFromFile("resources/main_font.ttf");
+        titleFont.loadFromFile("resources/title_font.ttf");
+        sf::Texture backgroundTexture;
+        sf::Texture logoTexture;
+        std::array<sf::Image, BoardRenderer::BLOCK_TYPES> images;
+        for (int i = 0; i < BoardRenderer::BLOCK_TYPES; ++i) {
+            images[i].create(BLOCK_SIZE, BLOCK_SIZE, sf::Color(40 * i, 255 - 30 * i, 128));
+        }
+        if (!backgroundTexture.create(SCREEN_WIDTH, SCREEN_HEIGHT) || !logoTexture.create(256, 128)) {
+            std::cerr << "Skipping render benchmarks: textures cannot be created\n";
+            return;
+        }
+        FrameProfiler profiler;
+        profiler.setHitchLog(nullptr);
+        FrameRenderer renderer(profiler);
+        try {
+            renderer.load(mainFont, titleFont, backgroundTexture, logoTexture, images);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Skipping render benchmarks: " << e.what() << "\n";
+            return;
+        }
+
+        TetrisEngine engine;
+        engine.loadBoard(fillColumns({ 3, 7, 2, 9, 5, 1, 8, 4, 6, 0 }, true));
+        engine.applyInput(Input::Hold);
+        FrameSnapshot frame;
+        frame.state = GameState::Playing;
+        frame.board = engine.getBoard();
+        frame.boardRevision = 1;
+        frame.currentPiece = engine.getCurrentPiece();
+        frame.ghostPiece = engine.getGhostPiece();
+        frame.hasHoldPiece = engine.hasHoldPiece();
+        frame.holdPiece = engine.getHoldPiece();
+        frame.previewCount = std::min(engine.getPreviewCount(), MAX_SHOWN_PREVIEWS);
+        for (int i = 0; i < frame.previewCount; ++i) {
+            frame.previewTypes[i] = engine.getPreviewType(i);
+        }
+        frame.score = 12300;
+        frame.level = 4;
+        frame.lines = 31;
+        frame.highScore = 45600;
+        for (int i = 0; i < 10000; ++i) {
+            renderer.addParticle(sf::Vector2f(static_cast<float>(i % 350), static_cast<float>(i % 875)), i % PIECE_TYPES);
+        }
+        // Lays out the text for this snapshot; no time passes, so the particles stay.
+        renderer.update(frame, 0.0f);
+
+        auto drawFrame = [&] {
+            profiler.beginFrame();
+            renderer.draw(target, frame);
+            target.display();
+            profiler.endFrame();
+            return 0;
+        };
+        run("frame/steady", drawFrame);
+        run("frame/board_redraw", [&] {
+            frame.boardRevision++;
+            return drawFrame();
+        });
+        run("frame/chrome_redraw", [&] {
+            frame.boardRevision++;
+            frame.score += 100;
+            return drawFrame();
+        });
+    }
+}
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        }
+        else if (arg == "--min-time" && i + 1 < argc) {
+            minSeconds = std::stod(argv[++i]);
+        }
+        else {
+            std::cerr << "usage: Benchmarks [--filter SUBSTRING] [--min-time SECONDS]\n";
+            return 2;
+        }
+    }
+
+    std::printf("benchmark,iterations,ns_per_op,allocs_per_op\n");
+    benchEngine();
+    benchBot();
+    benchPerfectClear();
+    benchParticles();
+    benchLeaderboard();
+    benchFrame();
+    return 0;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "TetrisEngine.h"
+
+#include <algorithm>
+#include <limits>
+
+struct AutoShiftConfig {
+    // Delayed auto-shift: how long left/right must be held before it repeats.
+    double delay = 0.133;
+    // Auto-repeat rate: seconds between repeated moves once DAS has charged.
+    // Zero moves the piece straight to the wall.
+    double repeatInterval = 0.033;
+    // Seconds between repeated soft drops while down is held.
+    double softDropInterval = 0.033;
+};
+
+// Turns held left/right/soft-drop keys into repeated Inputs. Key edges carry the
+// time they happened (seconds on any monotonic clock), and update() emits every
+// repeat due by a given time, so the repeat timing depends only on those
+// timestamps, not on how often update() runs. The initial move on a key press
+// is left to the caller.
+class AutoShift {
+public:
+    explicit AutoShift(const AutoShiftConfig& config = AutoShiftConfig()) : config(config) {
+        reset();
+    }
+
+    void reset() {
+        leftHeld = rightHeld = softDropHeld = false;
+        shifting = false;
+    }
+
+    void press(Input input, double time) {
+        switch (input) {
+        case Input::MoveLeft:
+            leftHeld = true;
+            startShift(Input::MoveLeft, time);
+            break;
+        case Input::MoveRight:
+            rightHeld = true;
+            startShift(Input::MoveRight, time);
+            break;
+        case Input::SoftDrop:
+            softDropHeld = true;
+            nextSoftDrop = time + config.softDropInterval;
+            break;
+        default:
+            break;
+        }
+    }
+
+    void release(Input input, double time) {
+        switch (input) {
+        case Input::MoveLeft:
+            leftHeld = false;
+            if (shifting && direction == Input::MoveLeft) {
+                // The other direction, if still held, takes over with a fresh delay.
+                shifting = false;
+                if (rightHeld) startShift(Input::MoveRight, time);
+            }
+            break;
+        case Input::MoveRight:
+            rightHeld = false;
+            if (shifting && direction == Input::MoveRight) {
+                shifting = false;
+                if (leftHeld) startShift(Input::MoveLeft, time);
+            }
+            break;
+        case Input::SoftDrop:
+            softDropHeld = false;
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Calls emit(input) for each repeat due at or before now. emit returns whether
+    // the move happened; with a zero repeat interval moves continue until one fails.
+    template <typename Emit>
+    void update(double now, Emit emit) {
+        if (shifting && nextShift <= now) {
+            if (config.repeatInterval <= 0.0) {
+                for (int i = 0; i < GRID_WIDTH && emit(direction); ++i) {
+                }
+                nextShift = now;
+            }
+            else {
+                // A long gap between updates catches up by at most one board width.
+                for (int i = 0; i < GRID_WIDTH && nextShift <= now; ++i) {
+                    emit(direction);
+                    nextShift += config.repeatInterval;
+                }
+                nextShift = std::max(nextShift, now - config.repeatInterval);
+            }
+        }
+
+        if (softDropHeld && config.softDropInterval > 0.0) {
+            for (int i = 0; i < GRID_HEIGHT && nextSoftDrop <= now; ++i) {
+                emit(Input::SoftDrop);
+                nextSoftDrop += config.softDropInterval;
+            }
+            nextSoftDrop = std::max(nextSoftDrop, now - config.softDropInterval);
+        }
+    }
+
+    const AutoShiftConfig& getConfig() const { return config; }
+
+private:
+    void startShift(Input input, double time) {
+        direction = input;
+        shifting = true;
+        nextShift = time + config.delay;
+    }
+
+    AutoShiftConfig config;
+    bool leftHeld;
+    bool rightHeld;
+    bool softDropHeld;
+    bool shifting;
+    Input direction = Input::MoveLeft;
+    double nextShift = 0.0;
+    double nextSoftDrop = std::numeric_limits<double>::infinity();
+};
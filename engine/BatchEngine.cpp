@@ -0,0 +1,304 @@
+#include "BatchEngine.h"
+#include "BatchKernel.h"
+
+#include <algorithm>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define BATCH_ENGINE_X86 1
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+namespace {
+    // Lanes set up, simulated and scored together by place().
+    const int CHUNK_LANES = 256;
+
+    // Every piece's four row masks (16 bits each, row 0 lowest) for each
+    // rotation with its leftmost column at x; zero where the piece would stick
+    // out past the right wall.
+    struct MoveMasks {
+        std::uint64_t masks[PIECE_TYPES][4][GRID_WIDTH];
+
+        MoveMasks() {
+            for (int type = 0; type < PIECE_TYPES; ++type) {
+                for (int rotation = 0; rotation < 4; ++rotation) {
+                    const PieceShape& shape = PIECE_SHAPES[type][rotation];
+                    for (int x = 0; x < GRID_WIDTH; ++x) {
+                        std::uint64_t packed = 0;
+                        if (x + shape.width <= GRID_WIDTH) {
+                            for (int i = 0; i < 4; ++i) {
+                                packed |= static_cast<std::uint64_t>(static_cast<std::uint16_t>(shape.rowMasks[i] << x)) << (16 * i);
+                            }
+                        }
+                        masks[type][rotation][x] = packed;
+                    }
+                }
+            }
+        }
+    };
+
+    const MoveMasks& moveMasks() {
+        static const MoveMasks table;
+        return table;
+    }
+
+    // The kernel's contract one lane at a time, the way TetrisEngine drops a
+    // piece: step down while it fits, lock, then clear only the rows it covers.
+    // Without SIMD there is nothing to gain from moving lanes in step, so this
+    // is the reference loop run on the lane-major rows, not a fast path.
+    void runBatchKernelScalar(const BatchKernelArgs& args) {
+        for (int lane = args.firstLane; lane < args.firstLane + args.laneCount; ++lane) {
+            std::uint16_t cleared = 0;
+            std::uint16_t blocked = 0;
+            if (args.live[lane]) {
+                std::uint16_t* rows = args.rows + batchRowIndex(lane, 0);
+                std::uint16_t masks[4];
+                std::uint16_t spawn[4];
+                for (int i = 0; i < 4; ++i) {
+                    masks[i] = args.pieceMasks[batchMaskIndex(lane, i)];
+                    spawn[i] = args.spawnMasks[batchMaskIndex(lane, i)];
+                }
+                // The rows under the floor are solid and a piece's unused rows
+                // have empty masks, so every test stays inside the lane's rows.
+                auto fitsAt = [rows](const std::uint16_t* pieceMasks, int y) {
+                    const std::uint16_t* row = rows + y * BATCH_GROUP;
+                    return ((row[0] & pieceMasks[0]) | (row[BATCH_GROUP] & pieceMasks[1]) |
+                        (row[2 * BATCH_GROUP] & pieceMasks[2]) | (row[3 * BATCH_GROUP] & pieceMasks[3])) == 0;
+                };
+
+                if (fitsAt(masks, 0)) {
+                    // Every piece fits anywhere above the lane's first filled row.
+                    int top = 0;
+                    while (top < GRID_HEIGHT && rows[top * BATCH_GROUP] == BATCH_WALLS) {
+                        top++;
+                    }
+                    int y = std::max(0, top - 4);
+                    while (fitsAt(masks, y + 1)) {
+                        y++;
+                    }
+                    for (int i = 0; i < 4; ++i) {
+                        rows[(y + i) * BATCH_GROUP] |= masks[i];
+                    }
+
+                    int bottom = std::min(y + 3, GRID_HEIGHT - 1);
+                    for (int row = y; row <= bottom; ++row) {
+                        cleared += rows[row * BATCH_GROUP] == BATCH_SOLID;
+                    }
+                    if (cleared > 0) {
+                        // The rows above move down over the full ones.
+                        int write = bottom;
+                        for (int read = bottom; read >= 0; --read) {
+                            std::uint16_t row = rows[read * BATCH_GROUP];
+                            if (read >= y && row == BATCH_SOLID) continue;
+                            rows[write * BATCH_GROUP] = row;
+                            write--;
+                        }
+                        for (; write >= 0; --write) {
+                            rows[write * BATCH_GROUP] = BATCH_WALLS;
+                        }
+                    }
+                    blocked = fitsAt(spawn, SPAWN_Y) ? 0 : 0xFFFF;
+                }
+                else {
+                    args.live[lane] = 0;
+                }
+            }
+            args.cleared[lane] = cleared;
+            args.blocked[lane] = blocked;
+        }
+    }
+
+#ifdef BATCH_ENGINE_X86
+    struct Sse2Lanes {
+        using Vec = __m128i;
+        static const int WIDTH = 8;
+        static Vec load(const std::uint16_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+        static void store(std::uint16_t* p, Vec v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+        static Vec set1(std::uint16_t value) { return _mm_set1_epi16(static_cast<short>(value)); }
+        static Vec bitAnd(Vec a, Vec b) { return _mm_and_si128(a, b); }
+        static Vec bitOr(Vec a, Vec b) { return _mm_or_si128(a, b); }
+        static Vec andNot(Vec a, Vec b) { return _mm_andnot_si128(a, b); }
+        static Vec equal(Vec a, Vec b) { return _mm_cmpeq_epi16(a, b); }
+        static Vec add(Vec a, Vec b) { return _mm_add_epi16(a, b); }
+        static bool any(Vec mask) { return _mm_movemask_epi8(mask) != 0; }
+    };
+
+    bool cpuHasAvx2() {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+        __cpuid(info, 1);
+        bool osSavesYmm = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+        __cpuidex(info, 7, 0);
+        return osSavesYmm && (info[1] & (1 << 5));
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+}
+
+// Defined in BatchEngineAvx2.cpp, the only file built with AVX2 enabled.
+void runBatchKernelAvx2(const BatchKernelArgs& args);
+
+bool isBatchKernelSupported(BatchKernel kernel) {
+    switch (kernel) {
+    case BatchKernel::Scalar:
+        return true;
+#ifdef BATCH_ENGINE_X86
+    case BatchKernel::Sse2:
+        return true;
+    case BatchKernel::Avx2: {
+        static const bool supported = cpuHasAvx2();
+        return supported;
+    }
+#endif
+    default:
+        return false;
+    }
+}
+
+BatchKernel bestBatchKernel() {
+    if (isBatchKernelSupported(BatchKernel::Avx2)) return BatchKernel::Avx2;
+    if (isBatchKernelSupported(BatchKernel::Sse2)) return BatchKernel::Sse2;
+    return BatchKernel::Scalar;
+}
+
+const char* batchKernelName(BatchKernel kernel) {
+    switch (kernel) {
+    case BatchKernel::Sse2: return "sse2";
+    case BatchKernel::Avx2: return "avx2";
+    default: return "scalar";
+    }
+}
+
+BatchEngine::BatchEngine(int laneCount, BatchKernel kernel)
+    : laneCount(laneCount), paddedLanes((laneCount + BATCH_GROUP - 1) / BATCH_GROUP * BATCH_GROUP), kernel(BatchKernel::Scalar),
+    bags(laneCount), pending(laneCount), pendingCounts(laneCount), scores(laneCount), levels(laneCount),
+    linesCleared(laneCount), over(laneCount), rows(static_cast<std::size_t>(BATCH_ROWS) * paddedLanes),
+    pieceMasks(static_cast<std::size_t>(4) * paddedLanes), spawnMasks(static_cast<std::size_t>(4) * paddedLanes),
+    live(paddedLanes), cleared(paddedLanes), blocked(paddedLanes) {
+    setKernel(kernel);
+    for (int lane = 0; lane < paddedLanes; ++lane) {
+        for (int y = 0; y < BATCH_ROWS; ++y) {
+            rows[batchRowIndex(lane, y)] = y < GRID_HEIGHT ? BATCH_WALLS : BATCH_SOLID;
+        }
+    }
+    for (int lane = 0; lane < laneCount; ++lane) {
+        reset(lane, lane);
+    }
+}
+
+void BatchEngine::setKernel(BatchKernel kernel) {
+    this->kernel = isBatchKernelSupported(kernel) ? kernel : BatchKernel::Scalar;
+}
+
+void BatchEngine::reset(int lane, std::uint64_t seed) {
+    bags[lane].reset(seed);
+    pending[lane] = 0;
+    pendingCounts[lane] = 0;
+    refillQueue(lane);
+    scores[lane] = 0;
+    levels[lane] = 1;
+    linesCleared[lane] = 0;
+    loadBoard(lane, Board());
+}
+
+void BatchEngine::loadBoard(int lane, const Board& board) {
+    for (int y = 0; y < GRID_HEIGHT; ++y) {
+        rows[batchRowIndex(lane, y)] = static_cast<std::uint16_t>(board.rows[y] | BATCH_WALLS);
+    }
+    over[lane] = spawnFits(lane, getCurrentType(lane)) ? 0 : 0xFFFF;
+}
+
+// Appends whole bags, so the lane's SevenBag is only asked for pieces seven at
+// a time and the sequence is the one PieceQueue gives for the same seed.
+void BatchEngine::refillQueue(int lane) {
+    while (pendingCounts[lane] < 8) {
+        for (int i = 0; i < 7; ++i) {
+            pending[lane] |= static_cast<std::uint64_t>(bags[lane].next()) << (4 * pendingCounts[lane]);
+            pendingCounts[lane]++;
+        }
+    }
+}
+
+RowMask BatchEngine::getRow(int lane, int y) const {
+    return static_cast<RowMask>(rows[batchRowIndex(lane, y)] & FULL_ROW);
+}
+
+bool BatchEngine::spawnFits(int lane, int type) const {
+    const PieceShape& shape = PIECE_SHAPES[type][0];
+    for (int i = 0; i < shape.height; ++i) {
+        if (rows[batchRowIndex(lane, SPAWN_Y + i)] & (shape.rowMasks[i] << SPAWN_X)) return false;
+    }
+    return true;
+}
+
+void BatchEngine::place(const BatchMove* moves) {
+    // A chunk at a time, so the lanes' state is still in cache for the
+    // bookkeeping after the kernel.
+    for (int first = 0; first < laneCount; first += CHUNK_LANES) {
+        placeChunk(moves, first, std::min(laneCount, first + CHUNK_LANES));
+    }
+}
+
+void BatchEngine::placeChunk(const BatchMove* moves, int first, int last) {
+    // The per-lane setup: each lane has its own piece, rotation and column,
+    // looked up as four packed row masks.
+    const MoveMasks& table = moveMasks();
+    for (int lane = first; lane < last; ++lane) {
+        std::uint64_t piece = 0;
+        std::uint64_t spawn = 0;
+        unsigned x = static_cast<unsigned>(moves[lane].x);
+        if (!over[lane] && x < static_cast<unsigned>(GRID_WIDTH)) {
+            std::uint64_t queue = pending[lane];
+            piece = table.masks[queue & 15][moves[lane].rotation & 3][x];
+            spawn = table.masks[(queue >> 4) & 15][0][SPAWN_X];
+        }
+        live[lane] = piece ? 0xFFFF : 0;
+        for (int i = 0; i < 4; ++i) {
+            pieceMasks[batchMaskIndex(lane, i)] = static_cast<std::uint16_t>(piece >> (16 * i));
+            spawnMasks[batchMaskIndex(lane, i)] = static_cast<std::uint16_t>(spawn >> (16 * i));
+        }
+    }
+
+    int paddedLast = std::min(paddedLanes, (last + BATCH_GROUP - 1) / BATCH_GROUP * BATCH_GROUP);
+    BatchKernelArgs args{ rows.data(), pieceMasks.data(), spawnMasks.data(), live.data(), cleared.data(), blocked.data(),
+        first, paddedLast - first };
+    switch (kernel) {
+#ifdef BATCH_ENGINE_X86
+    case BatchKernel::Avx2:
+        runBatchKernelAvx2(args);
+        break;
+    case BatchKernel::Sse2:
+        runBatchKernel<Sse2Lanes>(args);
+        break;
+#endif
+    default:
+        runBatchKernelScalar(args);
+        break;
+    }
+
+    // Scoring and the next piece, as TetrisEngine::checkRows and lockPiece do.
+    for (int lane = first; lane < last; ++lane) {
+        if (over[lane]) continue;
+        if (!live[lane]) {
+            over[lane] = 0xFFFF;
+            continue;
+        }
+        int rowsCleared = cleared[lane];
+        if (rowsCleared > 0) {
+            scores[lane] += lineClearScore(rowsCleared, levels[lane]);
+            linesCleared[lane] += rowsCleared;
+            levels[lane] = levelForLines(linesCleared[lane]);
+        }
+        pending[lane] >>= 4;
+        if (--pendingCounts[lane] < 8) {
+            refillQueue(lane);
+        }
+        over[lane] = blocked[lane];
+    }
+}
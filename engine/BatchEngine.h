@@ -0,0 +1,100 @@
+#pragma once
+
+#include "Random.h"
+#include "TetrisEngine.h"
+
+#include <cstdint>
+#include <vector>
+
+// Where one lane's current piece goes: its rotation and leftmost column. The
+// piece is dropped straight down from the spawn row.
+struct BatchMove {
+    std::uint8_t rotation = 0;
+    std::int8_t x = SPAWN_X;
+};
+
+// Instruction set the lockstep kernel runs on. Sse2 and Avx2 need an x86 CPU
+// with that extension (see isBatchKernelSupported). Scalar works everywhere but
+// places one lane at a time, about as fast as separate TetrisEngine boards.
+enum class BatchKernel {
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+bool isBatchKernelSupported(BatchKernel kernel);
+// The widest kernel this CPU can run.
+BatchKernel bestBatchKernel();
+const char* batchKernelName(BatchKernel kernel);
+
+// Many independent games advanced together, one placement per lane per call,
+// for rollouts and tuning that need boards by the thousand rather than inputs
+// and gravity. Boards are stored lane-major in groups of 16 lanes (row y of
+// every lane in a group is contiguous), so the drop, lock and line-clear steps
+// run on 8 (SSE2) or 16 (AVX2) lanes per instruction. The rules are the engine's: a placement that does not fit at the
+// spawn row, or a next piece that cannot spawn, ends the lane's game, and
+// clears score and level up as in TetrisEngine. Only the occupancy is kept, not
+// the color plane.
+class BatchEngine {
+public:
+    explicit BatchEngine(int laneCount, BatchKernel kernel = bestBatchKernel());
+
+    int getLaneCount() const { return laneCount; }
+    BatchKernel getKernel() const { return kernel; }
+    // Falls back to Scalar if the CPU lacks the requested extension.
+    void setKernel(BatchKernel kernel);
+
+    // Starts a new game in one lane, with the piece sequence TetrisEngine uses for seed.
+    void reset(int lane, std::uint64_t seed);
+    // Replaces one lane's locked cells, e.g. to start from a prepared position.
+    void loadBoard(int lane, const Board& board);
+
+    // Places the current piece of every lane still in play; moves holds one
+    // entry per lane and entries of finished lanes are ignored.
+    void place(const BatchMove* moves);
+
+    int getCurrentType(int lane) const { return static_cast<int>(pending[lane] & 15); }
+    // i must be less than 7; the engine shows EngineConfig::previewCount of them.
+    int getPreviewType(int lane, int i) const { return static_cast<int>((pending[lane] >> (4 * (i + 1))) & 15); }
+    int getScore(int lane) const { return scores[lane]; }
+    int getLevel(int lane) const { return levels[lane]; }
+    int getLinesCleared(int lane) const { return linesCleared[lane]; }
+    bool isGameOver(int lane) const { return over[lane] != 0; }
+    // Row y of lane as a RowMask (bit x = column x).
+    RowMask getRow(int lane, int y) const;
+
+private:
+    void placeChunk(const BatchMove* moves, int first, int last);
+    void refillQueue(int lane);
+    bool spawnFits(int lane, int type) const;
+
+    int laneCount;
+    // laneCount rounded up to whole groups of 16 lanes (see BatchKernel.h).
+    int paddedLanes;
+    BatchKernel kernel;
+    // Game state in one array per field, indexed by lane, so the setup and
+    // scoring loops around the kernel stream through it.
+    std::vector<SevenBag> bags;
+    // The lane's current piece in the low four bits and the pieces after it in
+    // the next four bits each, pendingCounts[lane] of them in all. A piece is
+    // taken by shifting; a bag of seven is appended whenever fewer than eight
+    // are left, so the current piece and a full preview are always there.
+    std::vector<std::uint64_t> pending;
+    std::vector<std::uint8_t> pendingCounts;
+    std::vector<int> scores;
+    std::vector<int> levels;
+    std::vector<int> linesCleared;
+    // All ones once the lane's game is over.
+    std::vector<std::uint16_t> over;
+    // Per group of 16 lanes, GRID_HEIGHT + 4 rows of 16 lanes. Columns past the
+    // right edge are stored filled and the four rows under the floor completely
+    // filled, so the kernels find walls and floor with the same test as locked
+    // cells.
+    std::vector<std::uint16_t> rows;
+    // Per-call kernel inputs and outputs (see BatchKernelArgs).
+    std::vector<std::uint16_t> pieceMasks;
+    std::vector<std::uint16_t> spawnMasks;
+    std::vector<std::uint16_t> live;
+    std::vector<std::uint16_t> cleared;
+    std::vector<std::uint16_t> blocked;
+};
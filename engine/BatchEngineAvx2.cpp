@@ -0,0 +1,46 @@
+// The AVX2 instantiation of the batch kernel. This is the only file that may
+// use AVX2 instructions: BatchEngine calls into it only after checking the CPU,
+// so the rest of the program still runs on machines without AVX2. GCC and Clang
+// enable AVX2 for the code below the engine headers; MSVC compiles the
+// intrinsics without any /arch switch.
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+
+#include "TetrisEngine.h"
+
+#include <cstdint>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC target("avx2")
+#endif
+
+#include "BatchKernel.h"
+
+#include <immintrin.h>
+
+namespace {
+    struct Avx2Lanes {
+        using Vec = __m256i;
+        static const int WIDTH = 16;
+        static Vec load(const std::uint16_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+        static void store(std::uint16_t* p, Vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+        static Vec set1(std::uint16_t value) { return _mm256_set1_epi16(static_cast<short>(value)); }
+        static Vec bitAnd(Vec a, Vec b) { return _mm256_and_si256(a, b); }
+        static Vec bitOr(Vec a, Vec b) { return _mm256_or_si256(a, b); }
+        static Vec andNot(Vec a, Vec b) { return _mm256_andnot_si256(a, b); }
+        static Vec equal(Vec a, Vec b) { return _mm256_cmpeq_epi16(a, b); }
+        static Vec add(Vec a, Vec b) { return _mm256_add_epi16(a, b); }
+        static bool any(Vec mask) { return !_mm256_testz_si256(mask, mask); }
+    };
+}
+
+void runBatchKernelAvx2(const BatchKernelArgs& args) {
+    runBatchKernel<Avx2Lanes>(args);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+
+#endif
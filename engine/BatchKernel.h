@@ -0,0 +1,151 @@
+#pragma once
+
+// The lockstep placement step of BatchEngine, written once against a lane-vector
+// type L and instantiated for SSE2 and AVX2. L provides Vec (a
+// vector of L::WIDTH 16-bit lanes) and load, store, set1, bitAnd, bitOr,
+// andNot(a, b) = ~a & b, equal (all ones where equal), add, and any, which
+// tells whether any lane of a mask (lanes all ones or all zeros) is set.
+#include "TetrisEngine.h"
+
+#include <cstdint>
+
+const std::uint16_t BATCH_WALLS = static_cast<std::uint16_t>(~FULL_ROW);
+const std::uint16_t BATCH_SOLID = 0xFFFF;
+const int BATCH_ROWS = GRID_HEIGHT + 4;
+// Lanes stored side by side: one AVX2 vector. Lanes are kept in groups of this
+// many, each group's rows together, so a group's boards share a few cache
+// lines instead of every row of a lane being a whole row of lanes apart.
+const int BATCH_GROUP = 16;
+
+// Static rather than inline: BatchEngineAvx2.cpp compiles this header with AVX2
+// enabled, and the linker must not pick that copy for the other files.
+static inline int batchRowIndex(int lane, int y) {
+    return (lane / BATCH_GROUP) * (BATCH_ROWS * BATCH_GROUP) + y * BATCH_GROUP + lane % BATCH_GROUP;
+}
+
+static inline int batchMaskIndex(int lane, int i) {
+    return (lane / BATCH_GROUP) * (4 * BATCH_GROUP) + i * BATCH_GROUP + lane % BATCH_GROUP;
+}
+
+// Per lane: the piece's four row masks at its column and the next piece's at
+// the spawn column (laid out by batchMaskIndex); live, all ones if the lane
+// places a piece, cleared to zero by the kernel when it does not fit; the rows
+// it cleared; and all ones in blocked when the next piece then cannot spawn.
+struct BatchKernelArgs {
+    std::uint16_t* rows;
+    const std::uint16_t* pieceMasks;
+    const std::uint16_t* spawnMasks;
+    std::uint16_t* live;
+    std::uint16_t* cleared;
+    std::uint16_t* blocked;
+    // The lanes to run, both multiples of BATCH_GROUP.
+    int firstLane;
+    int laneCount;
+};
+
+template <class L>
+void runBatchKernel(const BatchKernelArgs& args) {
+    using Vec = typename L::Vec;
+    const Vec zero = L::set1(0);
+    const Vec one = L::set1(1);
+    const Vec solid = L::set1(BATCH_SOLID);
+    const Vec walls = L::set1(BATCH_WALLS);
+
+    for (int lane = args.firstLane; lane < args.firstLane + args.laneCount; lane += L::WIDTH) {
+        std::uint16_t* rows = args.rows + batchRowIndex(lane, 0);
+        Vec live = L::load(args.live + lane);
+        if (!L::any(live)) {
+            L::store(args.cleared + lane, zero);
+            L::store(args.blocked + lane, zero);
+            continue;
+        }
+        Vec masks[4];
+        for (int i = 0; i < 4; ++i) {
+            masks[i] = L::load(args.pieceMasks + batchMaskIndex(lane, i));
+        }
+        // All ones in lanes where a piece with these masks fits with its top row at y.
+        auto fitsAt = [&](const Vec* pieceMasks, int y) {
+            Vec overlap = zero;
+            for (int i = 0; i < 4; ++i) {
+                overlap = L::bitOr(overlap, L::bitAnd(L::load(rows + (y + i) * BATCH_GROUP), pieceMasks[i]));
+            }
+            return L::equal(overlap, zero);
+        };
+
+        live = L::bitAnd(live, fitsAt(masks, 0));
+        L::store(args.live + lane, live);
+
+        // Drop and lock in one sweep down the rows: lanes fall in step while the
+        // piece fits one row lower, and lanes that stop lock into the rows above
+        // their last test. Row y - 1 and the four rows under test stay in
+        // registers; a row is written back once no lane can land on it any more.
+        // Every piece fits anywhere above the first row with a block in any lane.
+        int top = 0;
+        while (top < GRID_HEIGHT && !L::any(L::andNot(L::equal(L::load(rows + top * BATCH_GROUP), walls), solid))) {
+            top++;
+        }
+        int y = top > 4 ? top - 3 : 1;
+        Vec above = L::load(rows + (y - 1) * BATCH_GROUP);
+        Vec window[4];
+        for (int i = 0; i < 4; ++i) {
+            window[i] = L::load(rows + (y + i) * BATCH_GROUP);
+        }
+        Vec falling = live;
+        Vec completed = zero;
+        for (;;) {
+            Vec overlap = L::bitOr(L::bitOr(L::bitAnd(window[0], masks[0]), L::bitAnd(window[1], masks[1])),
+                L::bitOr(L::bitAnd(window[2], masks[2]), L::bitAnd(window[3], masks[3])));
+            Vec landed = L::andNot(L::equal(overlap, zero), falling);
+            falling = L::andNot(landed, falling);
+            above = L::bitOr(above, L::bitAnd(landed, masks[0]));
+            window[0] = L::bitOr(window[0], L::bitAnd(landed, masks[1]));
+            window[1] = L::bitOr(window[1], L::bitAnd(landed, masks[2]));
+            window[2] = L::bitOr(window[2], L::bitAnd(landed, masks[3]));
+            L::store(rows + (y - 1) * BATCH_GROUP, above);
+            completed = L::bitOr(completed, L::equal(above, solid));
+            if (!L::any(falling)) break;
+            y++;
+            above = window[0];
+            window[0] = window[1];
+            window[1] = window[2];
+            window[2] = window[3];
+            window[3] = L::load(rows + (y + 3) * BATCH_GROUP);
+        }
+        // The last pieces landed at y - 1; rows past the floor are never written.
+        for (int i = 0; i < 3 && y + i < GRID_HEIGHT; ++i) {
+            L::store(rows + (y + i) * BATCH_GROUP, window[i]);
+            completed = L::bitOr(completed, L::equal(window[i], solid));
+        }
+
+        // Clear: each pass removes the topmost full row of every lane that has
+        // one by moving the rows above it down a row.
+        Vec count = zero;
+        for (int pass = 0; pass < 4 && L::any(completed); ++pass) {
+            Vec hasFull = zero;
+            for (int y = 0; y < GRID_HEIGHT; ++y) {
+                hasFull = L::bitOr(hasFull, L::equal(L::load(rows + y * BATCH_GROUP), solid));
+            }
+            if (!L::any(hasFull)) break;
+            count = L::add(count, L::bitAnd(hasFull, one));
+
+            Vec previous = walls;
+            Vec passedFull = zero;
+            for (int y = 0; y < GRID_HEIGHT; ++y) {
+                std::uint16_t* row = rows + y * BATCH_GROUP;
+                Vec current = L::load(row);
+                Vec shift = L::andNot(passedFull, hasFull);
+                L::store(row, L::bitOr(L::bitAnd(shift, previous), L::andNot(shift, current)));
+                passedFull = L::bitOr(passedFull, L::equal(current, solid));
+                previous = current;
+            }
+        }
+        L::store(args.cleared + lane, count);
+
+        // Whether the next piece can spawn on the board left behind.
+        Vec spawn[4];
+        for (int i = 0; i < 4; ++i) {
+            spawn[i] = L::load(args.spawnMasks + batchMaskIndex(lane, i));
+        }
+        L::store(args.blocked + lane, L::andNot(fitsAt(spawn, SPAWN_Y), live));
+    }
+}
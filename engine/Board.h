@@ -0,0 +1,117 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+const int GRID_WIDTH = 10;
+const int GRID_HEIGHT = 25;
+
+// Playfield packed as one bitmask per row (bit x = column x) plus a color plane
+// holding a 3-bit color index per cell (0 = empty, otherwise piece type + 1).
+using RowMask = std::uint16_t;
+const RowMask FULL_ROW = static_cast<RowMask>((1u << GRID_WIDTH) - 1);
+const int COLOR_BITS = 3;
+const std::uint32_t COLOR_MASK = (1u << COLOR_BITS) - 1;
+
+static_assert(GRID_WIDTH <= 16, "RowMask must hold a full row");
+static_assert(GRID_WIDTH * COLOR_BITS <= 32, "color plane row must fit in 32 bits");
+static_assert(GRID_HEIGHT <= 32, "LineClear::rowMask must hold a bit per row");
+
+// Result of Board::clearFullRows. rowMask has bit y set for every cleared row
+// (indices as they were before the clear); colors holds those rows' color plane
+// words from the bottom row up, for effects.
+struct LineClear {
+    std::uint32_t rowMask = 0;
+    int count = 0;
+    std::array<std::uint32_t, 4> colors{};
+};
+
+struct Board {
+    std::array<RowMask, GRID_HEIGHT> rows;
+    std::array<std::uint32_t, GRID_HEIGHT> colors;
+    // Per-column stack height: rows from the floor up to and including the topmost
+    // filled cell (0 = empty column). Kept current by setCell and clears.
+    std::array<int, GRID_WIDTH> heights;
+
+    Board() { clear(); }
+
+    void clear() {
+        rows.fill(0);
+        colors.fill(0);
+        heights.fill(0);
+    }
+
+    bool isOccupied(int x, int y) const {
+        return (rows[y] >> x) & 1u;
+    }
+
+    int colorAt(int x, int y) const {
+        return static_cast<int>((colors[y] >> (x * COLOR_BITS)) & COLOR_MASK);
+    }
+
+    void setCell(int x, int y, int color) {
+        rows[y] |= static_cast<RowMask>(1u << x);
+        colors[y] = (colors[y] & ~(COLOR_MASK << (x * COLOR_BITS))) |
+            (static_cast<std::uint32_t>(color) << (x * COLOR_BITS));
+        heights[x] = std::max(heights[x], GRID_HEIGHT - y);
+    }
+
+    // After rowsCleared full rows were removed. Every full row lies at or below
+    // each column's top cell, so a surviving top cell moves down by exactly
+    // rowsCleared; only columns whose top cell was cleared need to scan down.
+    void updateHeightsAfterClear(int rowsCleared) {
+        for (int x = 0; x < GRID_WIDTH; ++x) {
+            int height = std::max(0, heights[x] - rowsCleared);
+            while (height > 0 && !isOccupied(x, GRID_HEIGHT - height)) {
+                height--;
+            }
+            heights[x] = height;
+        }
+    }
+
+    bool isRowFull(int y) const {
+        return rows[y] == FULL_ROW;
+    }
+
+    // Clears the full rows among [firstRow, lastRow], the only rows a piece that just
+    // locked there can have completed, and moves the surviving rows down in one pass.
+    LineClear clearFullRows(int firstRow, int lastRow) {
+        LineClear result;
+        firstRow = std::max(firstRow, 0);
+        lastRow = std::min(lastRow, GRID_HEIGHT - 1);
+        for (int y = lastRow; y >= firstRow; --y) {
+            if (isRowFull(y)) {
+                result.rowMask |= 1u << y;
+                result.colors[result.count++] = colors[y];
+            }
+        }
+        if (result.count == 0) return result;
+
+        // Rows above the tallest column are already empty and need no copying.
+        int stackTop = GRID_HEIGHT - *std::max_element(heights.begin(), heights.end());
+        int target = lastRow;
+        for (int y = lastRow; y >= stackTop; --y) {
+            if (result.rowMask & (1u << y)) continue;
+            rows[target] = rows[y];
+            colors[target] = colors[y];
+            target--;
+        }
+        for (; target >= stackTop; --target) {
+            rows[target] = 0;
+            colors[target] = 0;
+        }
+
+        updateHeightsAfterClear(result.count);
+        return result;
+    }
+
+    // Rows above the visible field (y < 0) are treated as empty.
+    bool collides(const RowMask* masks, int height, int x, int y) const {
+        for (int i = 0; i < height; ++i) {
+            int row = y + i;
+            if (row >= 0 && (rows[row] & (masks[i] << x))) return true;
+        }
+        return false;
+    }
+};
@@ -0,0 +1,169 @@
+#include "Bot.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+
+namespace {
+    // Score of a sequence that tops out; below anything that does not.
+    const double LOSS = std::numeric_limits<double>::lowest();
+
+    int bitCount(unsigned value) {
+        int count = 0;
+        for (; value; value &= value - 1) {
+            count++;
+        }
+        return count;
+    }
+
+    // Locks piece on board the way the engine does; returns the rows cleared.
+    int lockOnBoard(Board& board, const Piece& piece) {
+        for (const Cell& block : piece.getBlocks()) {
+            if (block.y >= 0) {
+                board.setCell(block.x, block.y, piece.type + 1);
+            }
+        }
+        return board.clearFullRows(piece.y, piece.y + piece.shape().height - 1).count;
+    }
+}
+
+bool parseBotWeights(const std::string& text, BotWeights& weights) {
+    std::istringstream in(text);
+    BotWeights parsed;
+    char a = 0, b = 0, c = 0;
+    in >> parsed.aggregateHeight >> a >> parsed.linesCleared >> b >> parsed.holes >> c >> parsed.bumpiness;
+    if (!in || a != ',' || b != ',' || c != ',' || !(in >> std::ws).eof()) return false;
+    weights = parsed;
+    return true;
+}
+
+BoardFeatures measureBoard(const Board& board) {
+    BoardFeatures features;
+    for (int x = 0; x < GRID_WIDTH; ++x) {
+        features.aggregateHeight += board.heights[x];
+        if (x > 0) {
+            features.bumpiness += std::abs(board.heights[x] - board.heights[x - 1]);
+        }
+    }
+    // Going down the rows, covered has a bit for every column with a filled cell above.
+    unsigned covered = 0;
+    for (int y = 0; y < GRID_HEIGHT; ++y) {
+        features.holes += bitCount(covered & ~static_cast<unsigned>(board.rows[y]));
+        covered |= board.rows[y];
+    }
+    return features;
+}
+
+double evaluateBoard(const Board& board, int linesCleared, const BotWeights& weights) {
+    BoardFeatures features = measureBoard(board);
+    return weights.aggregateHeight * features.aggregateHeight + weights.linesCleared * linesCleared +
+        weights.holes * features.holes + weights.bumpiness * features.bumpiness;
+}
+
+Bot::Bot(const BotConfig& config, ThreadPool* pool) : config(config), pool(pool) {}
+
+bool Bot::chooseMove(const TetrisEngine& engine, BotMove& move) {
+    if (engine.isGameOver()) return false;
+    const Board& board = engine.getBoard();
+    const Piece& current = engine.getCurrentPiece();
+    Piece swapped = MoveGenerator::holdSwapPiece(engine);
+    int heldType = engine.hasHoldPiece() ? engine.getHoldPiece().type : -1;
+
+    candidates.clear();
+    generator.generate(board, current, candidates);
+    if (config.useHold && engine.canHoldPiece() && swapped.type != current.type) {
+        generator.generate(board, swapped, candidates, true);
+    }
+    if (candidates.empty()) return false;
+
+    previews.clear();
+    for (int i = 0; i < engine.getPreviewCount(); ++i) {
+        previews.push_back(engine.getPreviewType(i));
+    }
+    auto previewAt = [this](int index) {
+        return index < static_cast<int>(previews.size()) ? previews[index] : -1;
+    };
+
+    scores.assign(candidates.size(), LOSS);
+    auto scoreCandidate = [&](int i) {
+        const Placement& candidate = candidates[i];
+        MoveGenerator taskGenerator;
+        int depth = config.lookahead;
+        if (!candidate.hold) {
+            scores[i] = scorePlacement(board, candidate.piece, previewAt(0), heldType, 1, depth, 0, previews, taskGenerator);
+        }
+        else if (heldType != -1) {
+            scores[i] = scorePlacement(board, candidate.piece, previewAt(0), current.type, 1, depth, 0, previews, taskGenerator);
+        }
+        else {
+            // Holding into an empty slot brings in the first preview piece.
+            scores[i] = scorePlacement(board, candidate.piece, previewAt(1), current.type, 2, depth, 0, previews, taskGenerator);
+        }
+    };
+    if (pool) {
+        pool->parallelFor(static_cast<int>(candidates.size()), scoreCandidate);
+    }
+    else {
+        for (int i = 0; i < static_cast<int>(candidates.size()); ++i) {
+            scoreCandidate(i);
+        }
+    }
+
+    // The first of equal scores wins, so the choice does not depend on timing.
+    std::size_t best = 0;
+    for (std::size_t i = 1; i < scores.size(); ++i) {
+        if (scores[i] > scores[best]) {
+            best = i;
+        }
+    }
+
+    move.placement = candidates[best];
+    move.score = scores[best];
+    const Piece& start = move.placement.hold ? swapped : current;
+    generator.findPath(board, start, move.placement.piece, move.inputs);
+    if (move.placement.hold) {
+        move.inputs.insert(move.inputs.begin(), Input::Hold);
+    }
+    return true;
+}
+
+double Bot::searchBest(const Board& board, int current, int hold, int next, int depth, int linesCleared,
+    const std::vector<int>& previews, MoveGenerator& generator) const {
+    auto previewAt = [&](int index) {
+        return index < static_cast<int>(previews.size()) ? previews[index] : -1;
+    };
+
+    double best = LOSS;
+    std::vector<Placement> placements;
+    generator.generate(board, Piece(current), placements);
+    for (const Placement& placement : placements) {
+        best = std::max(best, scorePlacement(board, placement.piece, previewAt(next), hold, next + 1,
+            depth - 1, linesCleared, previews, generator));
+    }
+    if (!config.useHold || hold == current) return best;
+
+    // Holding instead: place the held piece (or, with the slot empty, the next
+    // one) and keep this one.
+    int swapped = hold != -1 ? hold : previewAt(next);
+    int after = hold != -1 ? next : next + 1;
+    if (swapped == -1) return best;
+    placements.clear();
+    generator.generate(board, Piece(swapped), placements);
+    for (const Placement& placement : placements) {
+        best = std::max(best, scorePlacement(board, placement.piece, previewAt(after), current, after + 1,
+            depth - 1, linesCleared, previews, generator));
+    }
+    return best;
+}
+
+double Bot::scorePlacement(const Board& board, const Piece& piece, int current, int hold, int next, int depth,
+    int linesCleared, const std::vector<int>& previews, MoveGenerator& generator) const {
+    Board after = board;
+    linesCleared += lockOnBoard(after, piece);
+    if (current != -1 && !isValidPosition(Piece(current), after)) return LOSS;
+    if (depth == 0 || current == -1) {
+        return evaluateBoard(after, linesCleared, config.weights);
+    }
+    return searchBest(after, current, hold, next, depth, linesCleared, previews, generator);
+}
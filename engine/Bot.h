@@ -0,0 +1,81 @@
+#pragma once
+
+#include "MoveGenerator.h"
+#include "ThreadPool.h"
+
+#include <string>
+#include <vector>
+
+// Weights of the board features the bot scores positions by; higher is better.
+// The defaults are the widely used hand-tuned set for these four features.
+struct BotWeights {
+    double aggregateHeight = -0.510066;
+    double linesCleared = 0.760666;
+    double holes = -0.35663;
+    double bumpiness = -0.184483;
+};
+
+// Reads "aggregateHeight,linesCleared,holes,bumpiness", the form the Tuner
+// tool prints; false (leaving weights alone) if text is not four numbers.
+bool parseBotWeights(const std::string& text, BotWeights& weights);
+
+struct BoardFeatures {
+    // Sum of the column heights.
+    int aggregateHeight = 0;
+    // Empty cells with a filled cell somewhere above them.
+    int holes = 0;
+    // Sum of the height differences between neighbouring columns.
+    int bumpiness = 0;
+};
+
+BoardFeatures measureBoard(const Board& board);
+// Score of a position reached by clearing linesCleared rows along the way.
+double evaluateBoard(const Board& board, int linesCleared, const BotWeights& weights);
+
+struct BotConfig {
+    BotWeights weights;
+    // Preview pieces placed after the current one when scoring a move (0 = greedy).
+    int lookahead = 1;
+    bool useHold = true;
+};
+
+// The move the bot settled on: where the piece goes and the inputs that put it
+// there (starting with Hold when the held piece is used, ending with HardDrop).
+struct BotMove {
+    Placement placement;
+    std::vector<Input> inputs;
+    double score = 0.0;
+};
+
+// Plays by trying every placement of the current piece (and of the piece hold
+// would bring in), then of the next preview pieces on each resulting board, and
+// picking the first move of the best-scoring sequence. The first-level moves
+// are scored in parallel on the thread pool, each task searching its subtree
+// on its own; without a pool they are scored on the calling thread.
+class Bot {
+public:
+    explicit Bot(const BotConfig& config = BotConfig(), ThreadPool* pool = nullptr);
+
+    void setConfig(const BotConfig& config) { this->config = config; }
+    const BotConfig& getConfig() const { return config; }
+
+    // False when the current piece has nowhere to go (the game is over).
+    bool chooseMove(const TetrisEngine& engine, BotMove& move);
+
+private:
+    // Best score reachable from board with `current` to place next, `hold` in
+    // the hold slot (-1 if empty) and previews[next] onward still to come;
+    // depth more pieces are placed after this one.
+    double searchBest(const Board& board, int current, int hold, int next, int depth, int linesCleared,
+        const std::vector<int>& previews, MoveGenerator& generator) const;
+    // Locks piece on board and scores the result, searching on while depth allows.
+    double scorePlacement(const Board& board, const Piece& piece, int current, int hold, int next, int depth,
+        int linesCleared, const std::vector<int>& previews, MoveGenerator& generator) const;
+
+    BotConfig config;
+    ThreadPool* pool;
+    MoveGenerator generator;
+    std::vector<Placement> candidates;
+    std::vector<double> scores;
+    std::vector<int> previews;
+};
@@ -0,0 +1,605 @@
+#include "Leaderboard.h"
+#include "ResourcePack.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+    const char LOG_MAGIC[4] = { 'T', 'L', 'B', 'L' };
+    const char INDEX_MAGIC[4] = { 'T', 'L', 'B', 'X' };
+    const std::uint32_t FORMAT_VERSION = 1;
+    // Magic, version, generation.
+    const std::size_t LOG_HEADER_SIZE = 16;
+    // offset, timestamp, score, lines, level, duration, player, mode, live.
+    const std::size_t SUMMARY_SIZE = 8 + 8 + 4 * 5 + 1 + 1;
+
+    void putU8(std::vector<std::uint8_t>& out, std::uint8_t value) {
+        out.push_back(value);
+    }
+
+    void putU32(std::vector<std::uint8_t>& out, std::uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            out.push_back(static_cast<std::uint8_t>(value >> (i * 8)));
+        }
+    }
+
+    void putU64(std::vector<std::uint8_t>& out, std::uint64_t value) {
+        putU32(out, static_cast<std::uint32_t>(value));
+        putU32(out, static_cast<std::uint32_t>(value >> 32));
+    }
+
+    void putString(std::vector<std::uint8_t>& out, const std::string& value) {
+        std::size_t length = std::min<std::size_t>(value.size(), 0xFFFF);
+        out.push_back(static_cast<std::uint8_t>(length));
+        out.push_back(static_cast<std::uint8_t>(length >> 8));
+        out.insert(out.end(), value.begin(), value.begin() + length);
+    }
+
+    std::uint32_t getU32(const std::uint8_t* in) {
+        return static_cast<std::uint32_t>(in[0]) | static_cast<std::uint32_t>(in[1]) << 8 |
+            static_cast<std::uint32_t>(in[2]) << 16 | static_cast<std::uint32_t>(in[3]) << 24;
+    }
+
+    std::uint64_t getU64(const std::uint8_t* in) {
+        return getU32(in) | static_cast<std::uint64_t>(getU32(in + 4)) << 32;
+    }
+
+    // Bounds-checked little-endian reads; once a read runs past the end, ok
+    // turns false and every later read returns zero.
+    struct Reader {
+        const std::uint8_t* data;
+        std::size_t size;
+        std::size_t position;
+        bool ok;
+
+        Reader(const std::uint8_t* data, std::size_t size, std::size_t position = 0)
+            : data(data), size(size), position(position), ok(position <= size) {}
+
+        bool take(std::size_t count) {
+            if (!ok || size - position < count) {
+                ok = false;
+                return false;
+            }
+            position += count;
+            return true;
+        }
+        std::uint8_t u8() { return take(1) ? data[position - 1] : 0; }
+        std::uint16_t u16() { return take(2) ? static_cast<std::uint16_t>(data[position - 2] | data[position - 1] << 8) : 0; }
+        std::uint32_t u32() { return take(4) ? getU32(data + position - 4) : 0; }
+        std::uint64_t u64() { return take(8) ? getU64(data + position - 8) : 0; }
+        std::string string() {
+            std::uint16_t length = u16();
+            return take(length) ? std::string(reinterpret_cast<const char*>(data + position - length), length) : std::string();
+        }
+    };
+
+    // A log record: u32 payload length, payload, u32 CRC-32 of the payload.
+    void encodeRecord(const LeaderboardRecord& record, std::vector<std::uint8_t>& out) {
+        std::size_t start = out.size();
+        putU32(out, 0);
+        putU8(out, record.mode);
+        putU32(out, static_cast<std::uint32_t>(record.score));
+        putU32(out, static_cast<std::uint32_t>(record.lines));
+        putU32(out, static_cast<std::uint32_t>(record.level));
+        putU32(out, record.durationMs);
+        putU64(out, static_cast<std::uint64_t>(record.timestamp));
+        putString(out, record.player);
+        putString(out, record.replayPath);
+        std::uint32_t length = static_cast<std::uint32_t>(out.size() - start - 4);
+        for (int i = 0; i < 4; ++i) {
+            out[start + i] = static_cast<std::uint8_t>(length >> (i * 8));
+        }
+        putU32(out, crc32(out.data() + start + 4, length));
+    }
+
+    // Returns the size of the framed record at position, or 0 if it is torn or corrupt.
+    std::size_t decodeRecord(const std::uint8_t* log, std::size_t size, std::size_t position, LeaderboardRecord& record) {
+        if (size - position < 8) return 0;
+        std::uint32_t length = getU32(log + position);
+        if (size - position - 8 < length) return 0;
+        const std::uint8_t* payload = log + position + 4;
+        if (crc32(payload, length) != getU32(payload + length)) return 0;
+
+        Reader in(payload, length);
+        record.mode = in.u8();
+        record.score = static_cast<std::int32_t>(in.u32());
+        record.lines = static_cast<std::int32_t>(in.u32());
+        record.level = static_cast<std::int32_t>(in.u32());
+        record.durationMs = in.u32();
+        record.timestamp = static_cast<std::int64_t>(in.u64());
+        record.player = in.string();
+        record.replayPath = in.string();
+        return in.ok ? length + 8 : 0;
+    }
+
+    std::uint64_t newGeneration() {
+        std::random_device device;
+        return static_cast<std::uint64_t>(std::chrono::system_clock::now().time_since_epoch().count()) ^
+            (static_cast<std::uint64_t>(device()) << 32 | device());
+    }
+
+    std::FILE* createFile(const std::string& path) {
+#ifdef _WIN32
+        std::FILE* file = nullptr;
+        return fopen_s(&file, path.c_str(), "wb") == 0 ? file : nullptr;
+#else
+        return std::fopen(path.c_str(), "wb");
+#endif
+    }
+
+    // Flushes the file's data from the OS cache to the disk.
+    bool syncFile(std::FILE* file) {
+#ifdef _WIN32
+        return _commit(_fileno(file)) == 0;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
+
+    // The temporary file is synced before the rename, so after a crash path
+    // holds either the old contents or all of the new ones.
+    bool writeFileAtomically(const std::string& path, const std::vector<std::uint8_t>& bytes) {
+        std::string temporary = path + ".tmp";
+        std::FILE* file = createFile(temporary);
+        if (!file) return false;
+        bool written = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size() &&
+            std::fflush(file) == 0 && syncFile(file);
+        if (std::fclose(file) != 0 || !written) return false;
+        std::error_code error;
+        std::filesystem::rename(temporary, path, error);
+        return !error;
+    }
+}
+
+Leaderboard::Leaderboard() = default;
+
+Leaderboard::Leaderboard(const std::string& basePath, const LeaderboardConfig& config)
+    : logPath(basePath + ".log"), indexPath(basePath + ".idx"), config(config),
+    writer(&Leaderboard::writerLoop, this) {}
+
+Leaderboard::~Leaderboard() {
+    if (writer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        writer.join();
+    }
+    if (!logPath.empty() && generation != 0 && summaries.size() != indexedRecords) {
+        checkpoint();
+    }
+}
+
+bool Leaderboard::open() {
+    if (logPath.empty()) return true;
+
+    std::error_code sizeError;
+    std::uintmax_t existingSize = std::filesystem::file_size(logPath, sizeError);
+    if ((sizeError || existingSize < LOG_HEADER_SIZE) && !createLog()) {
+        return fail("cannot create " + logPath);
+    }
+    MappedFile log;
+    if (!log.open(logPath)) return fail("cannot map " + logPath);
+    if (std::memcmp(log.data(), LOG_MAGIC, sizeof(LOG_MAGIC)) != 0 || getU32(log.data() + 4) != FORMAT_VERSION) {
+        return fail(logPath + " is not a leaderboard log");
+    }
+    generation = getU64(log.data() + 8);
+
+    bool indexed = loadIndex(log.size());
+    if (!indexed) {
+        logEnd = LOG_HEADER_SIZE;
+    }
+    std::size_t firstNew = summaries.size();
+    logEnd = scanLog(log.data(), log.size(), static_cast<std::size_t>(logEnd));
+    // The per-player limit may have been lowered since the index was written.
+    bool overLimit = config.maxRecordsPerPlayer > 0 && std::any_of(playerRankings.begin(), playerRankings.end(),
+        [this](const auto& ranking) { return ranking.second.size() > config.maxRecordsPerPlayer; });
+    if (indexed && !overLimit) {
+        for (std::size_t id = firstNew; id < summaries.size(); ++id) {
+            insertRanked(static_cast<std::uint32_t>(id));
+        }
+    }
+    else {
+        rebuildRankings();
+    }
+
+    std::size_t logSize = log.size();
+    log.close();
+    if (logEnd < logSize) {
+        // Cut off a torn final record so appends follow the last good one.
+        std::error_code error;
+        std::filesystem::resize_file(logPath, logEnd, error);
+        if (error) return fail("cannot truncate " + logPath);
+    }
+
+    if (dropped > 0 && dropped >= config.compactionThreshold * summaries.size()) {
+        return compact();
+    }
+    if (!indexed || summaries.size() - indexedRecords >= config.checkpointInterval) {
+        return checkpoint();
+    }
+    return true;
+}
+
+std::uint32_t Leaderboard::add(const LeaderboardRecord& record) {
+    std::uint32_t id = static_cast<std::uint32_t>(summaries.size());
+    summaries.push_back(Summary{ logEnd, record.timestamp, record.score, record.lines, record.level,
+        record.durationMs, internPlayer(record.player), record.mode, true });
+    insertRanked(id);
+
+    if (!logPath.empty()) {
+        std::vector<std::uint8_t> frame;
+        encodeRecord(record, frame);
+        logEnd += frame.size();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.insert(pending.end(), frame.begin(), frame.end());
+        }
+        wake.notify_one();
+    }
+    return id;
+}
+
+std::size_t Leaderboard::size(std::uint8_t mode) const {
+    auto it = rankings.find(mode);
+    return it == rankings.end() ? 0 : it->second.size();
+}
+
+std::int32_t Leaderboard::bestScore(std::uint8_t mode) const {
+    auto it = rankings.find(mode);
+    return it == rankings.end() || it->second.empty() ? 0 : it->second.front().score;
+}
+
+void Leaderboard::top(std::uint8_t mode, std::size_t offset, std::size_t count, std::vector<std::uint32_t>& out) const {
+    out.clear();
+    auto it = rankings.find(mode);
+    if (it == rankings.end()) return;
+    const std::vector<RankKey>& ranking = it->second;
+    for (std::size_t i = offset; i < ranking.size() && i - offset < count; ++i) {
+        out.push_back(ranking[i].id);
+    }
+}
+
+std::size_t Leaderboard::rankOfScore(std::uint8_t mode, std::int32_t score) const {
+    auto it = rankings.find(mode);
+    if (it == rankings.end()) return 0;
+    const std::vector<RankKey>& ranking = it->second;
+    return std::partition_point(ranking.begin(), ranking.end(),
+        [score](const RankKey& key) { return key.score > score; }) - ranking.begin();
+}
+
+std::size_t Leaderboard::rankOf(std::uint32_t id) const {
+    const Summary& summary = summaries[id];
+    const std::vector<RankKey>& ranking = rankings.at(summary.mode);
+    return std::lower_bound(ranking.begin(), ranking.end(), RankKey{ summary.score, id }, ranksBefore) - ranking.begin();
+}
+
+void Leaderboard::playerRecords(const std::string& player, std::uint8_t mode, std::vector<std::uint32_t>& out) const {
+    out.clear();
+    auto playerIt = playerIds.find(player);
+    if (playerIt == playerIds.end()) return;
+    auto it = playerRankings.find(playerKey(playerIt->second, mode));
+    if (it == playerRankings.end()) return;
+    for (const RankKey& key : it->second) {
+        out.push_back(key.id);
+    }
+}
+
+bool Leaderboard::readRecord(std::uint32_t id, LeaderboardRecord& record) {
+    if (logPath.empty() || id >= summaries.size()) return false;
+    flush();
+    std::ifstream file(logPath, std::ios::binary);
+    if (!file.seekg(static_cast<std::streamoff>(summaries[id].offset))) return false;
+    std::uint8_t header[4];
+    if (!file.read(reinterpret_cast<char*>(header), sizeof(header))) return false;
+    std::vector<std::uint8_t> frame(header, header + sizeof(header));
+    frame.resize(8 + getU32(header));
+    if (!file.read(reinterpret_cast<char*>(frame.data() + 4), frame.size() - 4)) return false;
+    return decodeRecord(frame.data(), frame.size(), 0, record) != 0;
+}
+
+void Leaderboard::flush() {
+    if (!writer.joinable()) return;
+    std::unique_lock<std::mutex> lock(mutex);
+    drained.wait(lock, [this] { return pending.empty() && !writing; });
+}
+
+// Index layout (integers little-endian): "TLBX", version, log generation,
+// log bytes covered, players (count, then u16-length names), summaries
+// (count, then fixed-size entries), score rankings (mode count, then mode,
+// length, ids best first), player rankings (list count, then player, mode,
+// length, ids best first), CRC-32 of everything before it.
+bool Leaderboard::checkpoint() {
+    if (logPath.empty()) return true;
+    flush();
+
+    std::vector<std::uint8_t> out(INDEX_MAGIC, INDEX_MAGIC + sizeof(INDEX_MAGIC));
+    out.reserve(64 + summaries.size() * (SUMMARY_SIZE + 8));
+    putU32(out, FORMAT_VERSION);
+    putU64(out, generation);
+    putU64(out, logEnd);
+
+    putU32(out, static_cast<std::uint32_t>(playerNames.size()));
+    for (const std::string& name : playerNames) {
+        putString(out, name);
+    }
+
+    putU32(out, static_cast<std::uint32_t>(summaries.size()));
+    for (const Summary& summary : summaries) {
+        putU64(out, summary.offset);
+        putU64(out, static_cast<std::uint64_t>(summary.timestamp));
+        putU32(out, static_cast<std::uint32_t>(summary.score));
+        putU32(out, static_cast<std::uint32_t>(summary.lines));
+        putU32(out, static_cast<std::uint32_t>(summary.level));
+        putU32(out, summary.durationMs);
+        putU32(out, summary.player);
+        putU8(out, summary.mode);
+        putU8(out, summary.live ? 1 : 0);
+    }
+
+    putU32(out, static_cast<std::uint32_t>(rankings.size()));
+    for (const auto& ranking : rankings) {
+        putU8(out, ranking.first);
+        putU32(out, static_cast<std::uint32_t>(ranking.second.size()));
+        for (const RankKey& key : ranking.second) {
+            putU32(out, key.id);
+        }
+    }
+
+    putU32(out, static_cast<std::uint32_t>(playerRankings.size()));
+    for (const auto& ranking : playerRankings) {
+        putU32(out, static_cast<std::uint32_t>(ranking.first >> 8));
+        putU8(out, static_cast<std::uint8_t>(ranking.first));
+        putU32(out, static_cast<std::uint32_t>(ranking.second.size()));
+        for (const RankKey& key : ranking.second) {
+            putU32(out, key.id);
+        }
+    }
+    putU32(out, crc32(out.data(), out.size()));
+
+    if (!writeFileAtomically(indexPath, out)) return fail("cannot write " + indexPath);
+    indexedRecords = summaries.size();
+    return true;
+}
+
+bool Leaderboard::compact() {
+    if (logPath.empty()) return true;
+    flush();
+
+    std::uint64_t newGen = newGeneration();
+    std::vector<std::uint8_t> out(LOG_MAGIC, LOG_MAGIC + sizeof(LOG_MAGIC));
+    putU32(out, FORMAT_VERSION);
+    putU64(out, newGen);
+
+    std::vector<Summary> kept;
+    {
+        MappedFile log;
+        if (!log.open(logPath)) return fail("cannot map " + logPath);
+        for (const Summary& summary : summaries) {
+            if (!summary.live) continue;
+            const std::uint8_t* frame = log.data() + summary.offset;
+            std::size_t frameSize = 8 + getU32(frame);
+            Summary moved = summary;
+            moved.offset = out.size();
+            out.insert(out.end(), frame, frame + frameSize);
+            kept.push_back(moved);
+        }
+    }
+
+    if (!writeFileAtomically(logPath, out)) return fail("cannot write " + logPath);
+    generation = newGen;
+    logEnd = out.size();
+    summaries = std::move(kept);
+    rebuildRankings();
+    return checkpoint();
+}
+
+std::uint32_t Leaderboard::internPlayer(const std::string& name) {
+    auto it = playerIds.find(name);
+    if (it != playerIds.end()) return it->second;
+    std::uint32_t id = static_cast<std::uint32_t>(playerNames.size());
+    playerNames.push_back(name);
+    playerIds.emplace(name, id);
+    return id;
+}
+
+void Leaderboard::insertRanked(std::uint32_t id) {
+    const Summary& summary = summaries[id];
+    if (!summary.live) return;
+    RankKey key{ summary.score, id };
+    std::vector<RankKey>& mine = playerRankings[playerKey(summary.player, summary.mode)];
+    mine.insert(std::upper_bound(mine.begin(), mine.end(), key, ranksBefore), key);
+    std::vector<RankKey>& all = rankings[summary.mode];
+    all.insert(std::upper_bound(all.begin(), all.end(), key, ranksBefore), key);
+
+    if (config.maxRecordsPerPlayer > 0 && mine.size() > config.maxRecordsPerPlayer) {
+        RankKey worst = mine.back();
+        mine.pop_back();
+        summaries[worst.id].live = false;
+        dropped++;
+        all.erase(std::lower_bound(all.begin(), all.end(), worst, ranksBefore));
+    }
+}
+
+// Sorts everything from scratch: cheaper than inserting one by one when a
+// whole log is loaded.
+void Leaderboard::rebuildRankings() {
+    rankings.clear();
+    playerRankings.clear();
+    dropped = 0;
+    for (std::size_t id = 0; id < summaries.size(); ++id) {
+        const Summary& summary = summaries[id];
+        if (summary.live) {
+            playerRankings[playerKey(summary.player, summary.mode)].push_back(
+                RankKey{ summary.score, static_cast<std::uint32_t>(id) });
+        }
+        else {
+            dropped++;
+        }
+    }
+    for (auto& ranking : playerRankings) {
+        std::vector<RankKey>& keys = ranking.second;
+        std::sort(keys.begin(), keys.end(), ranksBefore);
+        while (config.maxRecordsPerPlayer > 0 && keys.size() > config.maxRecordsPerPlayer) {
+            summaries[keys.back().id].live = false;
+            dropped++;
+            keys.pop_back();
+        }
+    }
+    for (std::size_t id = 0; id < summaries.size(); ++id) {
+        const Summary& summary = summaries[id];
+        if (summary.live) {
+            rankings[summary.mode].push_back(RankKey{ summary.score, static_cast<std::uint32_t>(id) });
+        }
+    }
+    for (auto& ranking : rankings) {
+        std::sort(ranking.second.begin(), ranking.second.end(), ranksBefore);
+    }
+}
+
+// Adds a summary for each intact record from position on and returns where
+// the intact part of the log ends.
+std::size_t Leaderboard::scanLog(const std::uint8_t* log, std::size_t size, std::size_t position) {
+    LeaderboardRecord record;
+    while (std::size_t frameSize = decodeRecord(log, size, position, record)) {
+        summaries.push_back(Summary{ position, record.timestamp, record.score, record.lines, record.level,
+            record.durationMs, internPlayer(record.player), record.mode, true });
+        position += frameSize;
+    }
+    return position;
+}
+
+bool Leaderboard::loadIndex(std::size_t logSize) {
+    MappedFile file;
+    if (!file.open(indexPath) || file.size() < 32) return false;
+    const std::uint8_t* data = file.data();
+    std::size_t size = file.size() - 4;
+    if (std::memcmp(data, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 || crc32(data, size) != getU32(data + size)) {
+        return false;
+    }
+
+    Reader in(data, size, sizeof(INDEX_MAGIC));
+    if (in.u32() != FORMAT_VERSION || in.u64() != generation) return false;
+    std::uint64_t covered = in.u64();
+    if (covered < LOG_HEADER_SIZE || covered > logSize) return false;
+
+    std::uint32_t playerCount = in.u32();
+    for (std::uint32_t i = 0; i < playerCount && in.ok; ++i) {
+        internPlayer(in.string());
+    }
+
+    std::uint32_t count = in.u32();
+    if (!in.ok || (size - in.position) / SUMMARY_SIZE < count) {
+        in.ok = false;
+    }
+    else {
+        summaries.resize(count);
+    }
+    for (std::uint32_t i = 0; i < count && in.ok; ++i) {
+        Summary& summary = summaries[i];
+        summary.offset = in.u64();
+        summary.timestamp = static_cast<std::int64_t>(in.u64());
+        summary.score = static_cast<std::int32_t>(in.u32());
+        summary.lines = static_cast<std::int32_t>(in.u32());
+        summary.level = static_cast<std::int32_t>(in.u32());
+        summary.durationMs = in.u32();
+        summary.player = in.u32();
+        summary.mode = in.u8();
+        summary.live = in.u8() != 0;
+        if (summary.player >= playerNames.size() || summary.offset >= covered) in.ok = false;
+        if (!summary.live) dropped++;
+    }
+
+    auto readIds = [&](std::vector<RankKey>& keys) {
+        std::uint32_t length = in.u32();
+        if (!in.ok || (size - in.position) / 4 < length) {
+            in.ok = false;
+            return;
+        }
+        keys.reserve(length);
+        for (std::uint32_t i = 0; i < length; ++i) {
+            std::uint32_t id = in.u32();
+            if (id >= summaries.size()) {
+                in.ok = false;
+                return;
+            }
+            keys.push_back(RankKey{ summaries[id].score, id });
+        }
+    };
+    std::uint32_t modeCount = in.u32();
+    for (std::uint32_t i = 0; i < modeCount && in.ok; ++i) {
+        std::uint8_t mode = in.u8();
+        readIds(rankings[mode]);
+    }
+    std::uint32_t listCount = in.u32();
+    for (std::uint32_t i = 0; i < listCount && in.ok; ++i) {
+        std::uint32_t player = in.u32();
+        std::uint8_t mode = in.u8();
+        readIds(playerRankings[playerKey(player, mode)]);
+    }
+
+    if (!in.ok) {
+        summaries.clear();
+        playerNames.clear();
+        playerIds.clear();
+        rankings.clear();
+        playerRankings.clear();
+        dropped = 0;
+        return false;
+    }
+    logEnd = covered;
+    indexedRecords = summaries.size();
+    return true;
+}
+
+bool Leaderboard::createLog() {
+    std::vector<std::uint8_t> header(LOG_MAGIC, LOG_MAGIC + sizeof(LOG_MAGIC));
+    putU32(header, FORMAT_VERSION);
+    putU64(header, newGeneration());
+    return writeFileAtomically(logPath, header);
+}
+
+// Persistence stops, but the board keeps working in memory. The writer
+// thread reads logPath under the lock.
+bool Leaderboard::fail(const std::string& message) {
+    error = message;
+    std::lock_guard<std::mutex> lock(mutex);
+    logPath.clear();
+    return false;
+}
+
+void Leaderboard::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !pending.empty(); });
+        if (pending.empty()) return;
+
+        std::vector<std::uint8_t> batch;
+        batch.swap(pending);
+        std::string path = logPath;
+        writing = true;
+        lock.unlock();
+        std::ofstream file(path, std::ios::binary | std::ios::app);
+        file.write(reinterpret_cast<const char*>(batch.data()), batch.size());
+        file.flush();
+        if (!file.good()) {
+            std::cerr << "Failed to append to " << path << "\n";
+        }
+        lock.lock();
+        writing = false;
+        drained.notify_all();
+    }
+}
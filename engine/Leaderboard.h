@@ -0,0 +1,154 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct LeaderboardRecord {
+    std::string player;
+    std::uint8_t mode = 0;
+    std::int32_t score = 0;
+    std::int32_t lines = 0;
+    std::int32_t level = 0;
+    std::uint32_t durationMs = 0;
+    // Seconds since the Unix epoch.
+    std::int64_t timestamp = 0;
+    std::string replayPath;
+};
+
+struct LeaderboardConfig {
+    // A player's records beyond this many per mode drop off the board, worst
+    // first, and are removed from the log by the next compaction.
+    std::size_t maxRecordsPerPlayer = 1000;
+    // open() compacts the log once this fraction of its records has dropped off.
+    double compactionThreshold = 0.25;
+    // open() rewrites the index once this many records were appended after it.
+    std::size_t checkpointInterval = 256;
+};
+
+// Scores of every game played, ranked per mode and per player.
+//
+// Records are appended to <base>.log by a background thread, so add() never
+// waits on the disk. Each log record is framed with its length and a CRC-32;
+// a torn record at the end of the log (a crash mid-write) is cut off on open.
+// <base>.idx holds the per-record summaries and the score-ordered and
+// per-player rankings as of some log position, so open() only scans the log
+// past that point. The index is replaced by writing a temporary file and
+// renaming it, and it names the log generation it belongs to; a compacted log
+// gets a new generation, so a stale index is never paired with it.
+//
+// Rankings are kept as sorted arrays: top-N and paging cost O(N), rank lookups
+// O(log n), and an insert moves at most one array's worth of 8-byte keys.
+// A default-constructed leaderboard lives only in memory.
+//
+// All methods are meant for one thread; only the log writer runs beside it.
+class Leaderboard {
+public:
+    // What the rankings need about a record, kept in memory. readRecord()
+    // fetches the rest (player name as written, replay path) from the log.
+    struct Summary {
+        std::uint64_t offset;
+        std::int64_t timestamp;
+        std::int32_t score;
+        std::int32_t lines;
+        std::int32_t level;
+        std::uint32_t durationMs;
+        std::uint32_t player;
+        std::uint8_t mode;
+        bool live;
+    };
+
+    Leaderboard();
+    explicit Leaderboard(const std::string& basePath, const LeaderboardConfig& config = LeaderboardConfig());
+    // Finishes pending appends and checkpoints the index if it is behind.
+    ~Leaderboard();
+
+    Leaderboard(const Leaderboard&) = delete;
+    Leaderboard& operator=(const Leaderboard&) = delete;
+
+    // Loads the index and the log, creating them if missing; on failure
+    // getError() says why.
+    bool open();
+    const std::string& getError() const { return error; }
+
+    // Returns the new record's id.
+    std::uint32_t add(const LeaderboardRecord& record);
+
+    // Live records in a mode.
+    std::size_t size(std::uint8_t mode) const;
+    std::int32_t bestScore(std::uint8_t mode) const;
+    // Ids of the records ranked offset .. offset + count - 1 in a mode, best first.
+    void top(std::uint8_t mode, std::size_t offset, std::size_t count, std::vector<std::uint32_t>& out) const;
+    // How many live records in the mode score more (the rank a new score would take).
+    std::size_t rankOfScore(std::uint8_t mode, std::int32_t score) const;
+    // Rank (0 = best) of a live record within its mode.
+    std::size_t rankOf(std::uint32_t id) const;
+    // A player's live records in a mode, best first.
+    void playerRecords(const std::string& player, std::uint8_t mode, std::vector<std::uint32_t>& out) const;
+
+    const Summary& getSummary(std::uint32_t id) const { return summaries[id]; }
+    const std::string& getPlayerName(std::uint32_t player) const { return playerNames[player]; }
+    bool readRecord(std::uint32_t id, LeaderboardRecord& record);
+
+    std::size_t recordCount() const { return summaries.size(); }
+    std::size_t droppedCount() const { return dropped; }
+
+    // Blocks until every added record is in the log.
+    void flush();
+    // Writes the index for the whole log.
+    bool checkpoint();
+    // Rewrites the log without dropped records (ids are renumbered) and
+    // writes a fresh index.
+    bool compact();
+
+private:
+    // Ranking order: higher score first, then the earlier record.
+    struct RankKey {
+        std::int32_t score;
+        std::uint32_t id;
+    };
+    static bool ranksBefore(const RankKey& a, const RankKey& b) {
+        return a.score != b.score ? a.score > b.score : a.id < b.id;
+    }
+    static std::uint64_t playerKey(std::uint32_t player, std::uint8_t mode) {
+        return static_cast<std::uint64_t>(player) << 8 | mode;
+    }
+
+    std::uint32_t internPlayer(const std::string& name);
+    void insertRanked(std::uint32_t id);
+    void rebuildRankings();
+    std::size_t scanLog(const std::uint8_t* log, std::size_t size, std::size_t position);
+    bool loadIndex(std::size_t logSize);
+    bool createLog();
+    bool fail(const std::string& message);
+    void writerLoop();
+
+    std::string logPath;
+    std::string indexPath;
+    LeaderboardConfig config;
+    std::string error;
+    std::uint64_t generation = 0;
+    // End of the log including appends still queued for the writer.
+    std::uint64_t logEnd = 0;
+    std::size_t indexedRecords = 0;
+    std::size_t dropped = 0;
+
+    std::vector<Summary> summaries;
+    std::vector<std::string> playerNames;
+    std::unordered_map<std::string, std::uint32_t> playerIds;
+    std::unordered_map<std::uint8_t, std::vector<RankKey>> rankings;
+    std::unordered_map<std::uint64_t, std::vector<RankKey>> playerRankings;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable drained;
+    std::vector<std::uint8_t> pending;
+    bool writing = false;
+    bool stopping = false;
+    std::thread writer;
+};
@@ -0,0 +1,187 @@
+#include "MoveGenerator.h"
+
+#include <algorithm>
+
+void MoveGenerator::generate(const Board& board, const Piece& start, std::vector<Placement>& out, bool hold) {
+    if (!isValidPosition(start, board)) return;
+    prepare(board, start.type);
+    int count = search(start);
+    for (int i = 0; i < count; ++i) {
+        const State& state = queue[i];
+        if (!rests(state)) continue;
+        Placement placement;
+        placement.piece = Piece(start.type);
+        placement.piece.x = state.x;
+        placement.piece.y = state.y;
+        placement.piece.rotation = state.rotation;
+        placement.hold = hold;
+        out.push_back(placement);
+    }
+}
+
+void MoveGenerator::generate(const TetrisEngine& engine, std::vector<Placement>& out) {
+    out.clear();
+    if (engine.isGameOver()) return;
+    generate(engine.getBoard(), engine.getCurrentPiece(), out);
+    Piece swapped = holdSwapPiece(engine);
+    // Holding a piece of the same type only costs the hold.
+    if (engine.canHoldPiece() && swapped.type != engine.getCurrentPiece().type) {
+        generate(engine.getBoard(), swapped, out, true);
+    }
+}
+
+bool MoveGenerator::findPath(const Board& board, const Piece& start, const Piece& target, std::vector<Input>& out) {
+    out.clear();
+    if (target.type != start.type || !isValidPosition(start, board)) return false;
+    prepare(board, start.type);
+    int count = search(start);
+
+    int rotation = target.rotation % rotationCount;
+    int found = -1;
+    for (int i = 0; i < count && found < 0; ++i) {
+        const State& state = queue[i];
+        if (state.x == target.x && state.y == target.y && state.rotation == rotation) {
+            found = i;
+        }
+    }
+    if (found < 0 || !rests(queue[found])) return false;
+
+    for (int i = found; i > 0; i = parents[i]) {
+        out.push_back(moves[i]);
+    }
+    std::reverse(out.begin(), out.end());
+    while (!out.empty() && out.back() == Input::SoftDrop) {
+        out.pop_back();
+    }
+    out.push_back(Input::HardDrop);
+    return true;
+}
+
+bool MoveGenerator::findFinesse(const Board& board, const Piece& start, const Piece& target, std::vector<FinesseKey>& out) {
+    out.clear();
+    if (target.type != start.type || !isValidPosition(start, board)) return false;
+    prepare(board, start.type);
+    int found = searchFinesse(start, target);
+    if (found < 0) return false;
+
+    for (int i = found; i > 0; i = parents[i]) {
+        out.push_back(keys[i]);
+    }
+    std::reverse(out.begin(), out.end());
+    out.push_back(FinesseKey::HardDrop);
+    return true;
+}
+
+Piece MoveGenerator::holdSwapPiece(const TetrisEngine& engine) {
+    return engine.hasHoldPiece() ? Piece(engine.getHoldPiece().type) : engine.getNextPiece();
+}
+
+void MoveGenerator::prepare(const Board& board, int type) {
+    rotationCount = ROTATION_COUNTS[type];
+    for (int rotation = 0; rotation < rotationCount; ++rotation) {
+        const PieceShape& shape = PIECE_SHAPES[type][rotation];
+        std::array<RowMask, GRID_HEIGHT + 1>& masks = fitMasks[rotation];
+        masks.fill(0);
+        for (int y = 0; y + shape.height <= GRID_HEIGHT; ++y) {
+            // Bit x of blocked: the piece overlaps a filled cell when placed at column x.
+            unsigned blocked = 0;
+            for (int i = 0; i < shape.height; ++i) {
+                for (int column = 0; column < shape.width; ++column) {
+                    if ((shape.rowMasks[i] >> column) & 1u) {
+                        blocked |= static_cast<unsigned>(board.rows[y + i]) >> column;
+                    }
+                }
+            }
+            unsigned inBounds = (1u << (GRID_WIDTH - shape.width + 1)) - 1;
+            masks[y] = static_cast<RowMask>(~blocked & inBounds);
+        }
+        visited[rotation].fill(0);
+    }
+}
+
+int MoveGenerator::search(const Piece& start) {
+    int rotation = start.rotation % rotationCount;
+    queue[0] = State{ static_cast<std::int8_t>(start.x), static_cast<std::int8_t>(start.y), static_cast<std::int8_t>(rotation) };
+    parents[0] = -1;
+    visited[rotation][start.y] |= static_cast<RowMask>(1u << start.x);
+
+    int count = 1;
+    auto tryVisit = [&](int from, int x, int y, int rotation, Input move) {
+        if (!fits(x, y, rotation)) return;
+        RowMask bit = static_cast<RowMask>(1u << x);
+        if (visited[rotation][y] & bit) return;
+        visited[rotation][y] |= bit;
+        queue[count] = State{ static_cast<std::int8_t>(x), static_cast<std::int8_t>(y), static_cast<std::int8_t>(rotation) };
+        parents[count] = static_cast<std::int16_t>(from);
+        moves[count] = move;
+        count++;
+    };
+
+    for (int i = 0; i < count; ++i) {
+        State state = queue[i];
+        tryVisit(i, state.x - 1, state.y, state.rotation, Input::MoveLeft);
+        tryVisit(i, state.x + 1, state.y, state.rotation, Input::MoveRight);
+        tryVisit(i, state.x, state.y + 1, state.rotation, Input::SoftDrop);
+        if (rotationCount > 1) {
+            tryVisit(i, state.x, state.y, (state.rotation + 1) % rotationCount, Input::Rotate);
+        }
+    }
+    return count;
+}
+
+int MoveGenerator::searchFinesse(const Piece& start, const Piece& target) {
+    int targetRotation = target.rotation % rotationCount;
+    if (!fits(target.x, target.y, targetRotation) || fits(target.x, target.y + 1, targetRotation)) return -1;
+
+    int rotation = start.rotation % rotationCount;
+    queue[0] = State{ static_cast<std::int8_t>(start.x), static_cast<std::int8_t>(start.y), static_cast<std::int8_t>(rotation) };
+    parents[0] = -1;
+    visited[rotation][start.y] |= static_cast<RowMask>(1u << start.x);
+
+    int count = 1;
+    auto tryVisit = [&](int from, int x, int y, int rotation, FinesseKey key) {
+        if (!fits(x, y, rotation)) return;
+        RowMask bit = static_cast<RowMask>(1u << x);
+        if (visited[rotation][y] & bit) return;
+        visited[rotation][y] |= bit;
+        queue[count] = State{ static_cast<std::int8_t>(x), static_cast<std::int8_t>(y), static_cast<std::int8_t>(rotation) };
+        parents[count] = static_cast<std::int16_t>(from);
+        keys[count] = key;
+        count++;
+    };
+
+    // Breadth first, so the first state a hard drop takes to target has the
+    // fewest presses. A held key runs until the next step would not fit.
+    for (int i = 0; i < count; ++i) {
+        State state = queue[i];
+        if (state.x == target.x && state.rotation == targetRotation && state.y <= target.y) {
+            int y = state.y;
+            while (fits(state.x, y + 1, state.rotation)) {
+                y++;
+            }
+            if (y == target.y) return i;
+        }
+        int left = state.x;
+        while (fits(left - 1, state.y, state.rotation)) {
+            left--;
+        }
+        int right = state.x;
+        while (fits(right + 1, state.y, state.rotation)) {
+            right++;
+        }
+        int bottom = state.y;
+        while (fits(state.x, bottom + 1, state.rotation)) {
+            bottom++;
+        }
+        tryVisit(i, state.x - 1, state.y, state.rotation, FinesseKey::Left);
+        tryVisit(i, state.x + 1, state.y, state.rotation, FinesseKey::Right);
+        tryVisit(i, left, state.y, state.rotation, FinesseKey::DasLeft);
+        tryVisit(i, right, state.y, state.rotation, FinesseKey::DasRight);
+        if (rotationCount > 1) {
+            tryVisit(i, state.x, state.y, (state.rotation + 1) % rotationCount, FinesseKey::Rotate);
+        }
+        tryVisit(i, state.x, bottom, state.rotation, FinesseKey::SoftDrop);
+        tryVisit(i, state.x, state.y + 1, state.rotation, FinesseKey::Down);
+    }
+    return -1;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "TetrisEngine.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// A resting position a piece can be locked in.
+struct Placement {
+    Piece piece;
+    // The piece is the one Input::Hold brings in rather than the current piece.
+    bool hold = false;
+};
+
+// One key press in a finesse sequence. DasLeft and DasRight hold the key until
+// the piece stops against the wall or the stack, and SoftDrop holds down until
+// the piece lands, so each counts as a single press. Down taps soft drop for
+// one row, to stop level with a gap the piece then slides or rotates into.
+enum class FinesseKey : std::uint8_t {
+    Left,
+    Right,
+    DasLeft,
+    DasRight,
+    Rotate,
+    SoftDrop,
+    Down,
+    HardDrop,
+    Hold
+};
+
+// Finds every position a piece can come to rest in using the engine's own
+// moves (shift, soft drop and clockwise rotation without kicks), so tucks and
+// spins under overhangs are found, not just straight drops.
+//
+// The search is a BFS over (rotation, y, x). Before it starts, the columns the
+// piece fits in are computed as one bitmask per rotation and row, so expanding
+// a state is a handful of bit tests; visited states are a bitmask per rotation
+// and row as well. Rotations cycle through ROTATION_COUNTS[type] states, so the
+// symmetric orientations of the O, I, S and Z pieces are neither searched nor
+// reported twice. Nothing is allocated once out has grown to size.
+class MoveGenerator {
+public:
+    // Appends every resting placement reachable from start, which must be valid.
+    void generate(const Board& board, const Piece& start, std::vector<Placement>& out, bool hold = false);
+    // Replaces out with the current piece's placements followed, when holding
+    // is allowed, by those of the piece Input::Hold would bring in.
+    void generate(const TetrisEngine& engine, std::vector<Placement>& out);
+
+    // Fewest inputs that move start to target, followed by the HardDrop that
+    // locks it (trailing soft drops are folded into it). False if target is
+    // not a reachable resting placement.
+    bool findPath(const Board& board, const Piece& start, const Piece& target, std::vector<Input>& out);
+    // Fewest key presses that move start to target and lock it there, ending
+    // with HardDrop. Unlike findPath, a held shift or soft drop is one press, the
+    // way finesse is counted. False if target is not a reachable resting placement.
+    bool findFinesse(const Board& board, const Piece& start, const Piece& target, std::vector<FinesseKey>& out);
+
+    // The piece Input::Hold would make current, at its spawn position.
+    static Piece holdSwapPiece(const TetrisEngine& engine);
+
+private:
+    struct State {
+        std::int8_t x;
+        std::int8_t y;
+        std::int8_t rotation;
+    };
+    static const int MAX_STATES = 4 * GRID_WIDTH * GRID_HEIGHT;
+
+    void prepare(const Board& board, int type);
+    bool fits(int x, int y, int rotation) const {
+        return x >= 0 && (fitMasks[rotation][y] >> x) & 1u;
+    }
+    bool rests(const State& state) const {
+        return !fits(state.x, state.y + 1, state.rotation);
+    }
+    // Fills queue with every state reachable from start and returns how many.
+    int search(const Piece& start);
+    // Index in queue of the state found by a finesse search for target, or -1.
+    int searchFinesse(const Piece& start, const Piece& target);
+
+    int rotationCount = 0;
+    // Bit x of fitMasks[rotation][y] is set when the piece fits at (x, y). The
+    // extra row is all zero, so the bottom row reads as resting.
+    std::array<std::array<RowMask, GRID_HEIGHT + 1>, 4> fitMasks;
+    std::array<std::array<RowMask, GRID_HEIGHT>, 4> visited;
+    std::array<State, MAX_STATES> queue;
+    // The queue index each state was reached from and the input (or, in a
+    // finesse search, the key) used, for findPath and findFinesse.
+    std::array<std::int16_t, MAX_STATES> parents;
+    std::array<Input, MAX_STATES> moves;
+    std::array<FinesseKey, MAX_STATES> keys;
+};
@@ -0,0 +1,339 @@
+#include "PerfectClear.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+    // Fixed, so hashes (and a table kept across searches) mean the same on every run.
+    const std::uint64_t ZOBRIST_SEED = 0x5A0B215Bull;
+    const int NO_SOLUTION = std::numeric_limits<int>::max();
+
+    int bitCount(unsigned value) {
+        int count = 0;
+        for (; value; value &= value - 1) {
+            count++;
+        }
+        return count;
+    }
+
+    int stackHeight(const Board& board) {
+        return *std::max_element(board.heights.begin(), board.heights.end());
+    }
+
+    // Filled cells in the bottom rows rows.
+    int filledCells(const Board& board, int rows) {
+        int count = 0;
+        for (int y = GRID_HEIGHT - rows; y < GRID_HEIGHT; ++y) {
+            count += bitCount(board.rows[y]);
+        }
+        return count;
+    }
+
+    // Locks piece on board the way the engine does; returns the rows cleared.
+    int lockOnBoard(Board& board, const Piece& piece) {
+        for (const Cell& block : piece.getBlocks()) {
+            board.setCell(block.x, block.y, piece.type + 1);
+        }
+        return board.clearFullRows(piece.y, piece.y + piece.shape().height - 1).count;
+    }
+}
+
+ZobristKeys::ZobristKeys() {
+    Rng rng(ZOBRIST_SEED);
+    for (auto& row : cells) {
+        for (std::uint64_t& key : row) {
+            key = rng.next();
+        }
+    }
+    for (std::uint64_t& key : holds) {
+        key = rng.next();
+    }
+    for (auto& offset : queue) {
+        for (std::uint64_t& key : offset) {
+            key = rng.next();
+        }
+    }
+    for (std::uint64_t& key : lengths) {
+        key = rng.next();
+    }
+    for (std::uint64_t& key : rowCounts) {
+        key = rng.next();
+    }
+}
+
+std::uint64_t ZobristKeys::board(const Board& board, int firstRow) const {
+    std::uint64_t hash = 0;
+    for (int y = firstRow; y < GRID_HEIGHT; ++y) {
+        for (unsigned row = board.rows[y]; row; row &= row - 1) {
+            int x = 0;
+            while (!((row >> x) & 1u)) {
+                x++;
+            }
+            hash ^= cells[y][x];
+        }
+    }
+    return hash;
+}
+
+TranspositionTable::TranspositionTable(int bits) {
+    std::size_t buckets = std::size_t(1) << std::max(0, bits - 2);
+    entries = std::make_unique<std::atomic<std::uint64_t>[]>(buckets * BUCKET_SIZE);
+    bucketMask = buckets - 1;
+    clear();
+}
+
+void TranspositionTable::clear() {
+    for (std::size_t i = 0; i < capacity(); ++i) {
+        entries[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+// Entries carry no data beyond themselves, so relaxed loads and stores are enough.
+bool TranspositionTable::contains(std::uint64_t hash) const {
+    std::uint64_t entry = entryOf(hash);
+    const std::atomic<std::uint64_t>* bucket = &entries[(entry & bucketMask) * BUCKET_SIZE];
+    for (int i = 0; i < BUCKET_SIZE; ++i) {
+        if (bucket[i].load(std::memory_order_relaxed) == entry) return true;
+    }
+    return false;
+}
+
+void TranspositionTable::insert(std::uint64_t hash) {
+    std::uint64_t entry = entryOf(hash);
+    std::atomic<std::uint64_t>* bucket = &entries[(entry & bucketMask) * BUCKET_SIZE];
+    for (int i = 0; i < BUCKET_SIZE; ++i) {
+        std::uint64_t seen = bucket[i].load(std::memory_order_relaxed);
+        if (seen == 0 && bucket[i].compare_exchange_strong(seen, entry, std::memory_order_relaxed)) return;
+        if (seen == entry) return;
+    }
+    // Full: the top bits pick the entry to replace, independently of the bucket.
+    bucket[entry >> 62].store(entry, std::memory_order_relaxed);
+}
+
+struct PerfectClearSolver::Search {
+    std::vector<int> queue;
+    // Hash of queue[i] onward for every i, so positions are told apart only by
+    // the pieces still to come.
+    std::vector<std::uint64_t> remainingHashes;
+    const std::atomic<bool>* cancel = nullptr;
+    std::atomic<std::uint64_t> nodes{ 0 };
+    std::atomic<bool> outOfNodes{ false };
+    // Lowest first placement known to lead to a solution; searches of higher
+    // ones stop.
+    std::atomic<int> solvedRoot{ NO_SOLUTION };
+};
+
+struct PerfectClearSolver::Worker {
+    MoveGenerator generator;
+    // Placements per depth, so a level's list survives the search below it.
+    // Every placement uses up a known piece, so the depth is bounded.
+    std::array<std::vector<Placement>, MAX_PIECES> placements;
+};
+
+PerfectClearSolver::PerfectClearSolver(const PerfectClearConfig& config, ThreadPool* pool)
+    : config(config), pool(pool), table(config.tableBits) {}
+
+PerfectClearResult PerfectClearSolver::solve(const TetrisEngine& engine, const std::atomic<bool>* cancel) {
+    if (engine.isGameOver()) return PerfectClearResult();
+    std::vector<int> queue;
+    queue.push_back(engine.getCurrentPiece().type);
+    for (int i = 0; i < engine.getPreviewCount(); ++i) {
+        queue.push_back(engine.getPreviewType(i));
+    }
+    int hold = engine.hasHoldPiece() ? engine.getHoldPiece().type : -1;
+    return solve(engine.getBoard(), queue, hold, engine.canHoldPiece(), cancel);
+}
+
+PerfectClearResult PerfectClearSolver::solve(const Board& board, const std::vector<int>& queue, int hold, bool canHold,
+    const std::atomic<bool>* cancel) {
+    PerfectClearResult result;
+    Search search;
+    search.cancel = cancel;
+    search.queue.assign(queue.begin(), queue.begin() + std::min<std::size_t>(queue.size(), ZobristKeys::MAX_QUEUE));
+    int queueSize = static_cast<int>(search.queue.size());
+    search.remainingHashes.resize(queueSize + 1);
+    for (int i = 0; i <= queueSize; ++i) {
+        std::uint64_t hash = keys.queueLength(queueSize - i);
+        for (int j = i; j < queueSize; ++j) {
+            hash ^= keys.queued(j - i, search.queue[j]);
+        }
+        search.remainingHashes[i] = hash;
+    }
+
+    // Each extra row to clear takes 2.5 more pieces, so only every other
+    // height can be cleared with whole pieces.
+    int height = stackHeight(board);
+    int cells = filledCells(board, height);
+    int maxPieces = std::min(config.maxPieces, queueSize + (config.useHold && hold != -1 ? 1 : 0));
+    for (int rows = std::max(height, 1); rows <= std::min(config.maxHeight, GRID_HEIGHT); ++rows) {
+        int empty = rows * GRID_WIDTH - cells;
+        if (empty % 4 != 0) continue;
+        if (empty / 4 > maxPieces) break;
+
+        Node root;
+        root.board = board;
+        root.boardHash = keys.board(board, GRID_HEIGHT - rows);
+        root.hold = hold;
+        root.rowsLeft = rows;
+        if (searchRoot(root, search, canHold, result.steps)) {
+            result.status = PerfectClearStatus::Found;
+            break;
+        }
+        if (search.outOfNodes || (cancel && *cancel)) {
+            result.status = PerfectClearStatus::Unknown;
+            break;
+        }
+    }
+    result.nodes = std::min<std::uint64_t>(search.nodes, config.maxNodes);
+    return result;
+}
+
+template <typename Visit>
+bool PerfectClearSolver::expand(const Node& node, const Search& search, bool canHold, Worker& worker, int depth,
+    Visit visit) const {
+    const std::vector<int>& queue = search.queue;
+    int queueSize = static_cast<int>(queue.size());
+
+    // The piece placed, and where the queue and the hold slot stand after it:
+    // the current piece, then the one hold brings in (with the slot empty, the
+    // one after the current piece). Past the end of the queue only the held
+    // piece is left; holding puts a piece not yet known in the slot, recorded
+    // as empty since nothing can be placed after it.
+    struct Option {
+        int type;
+        int next;
+        int hold;
+        bool held;
+    };
+    std::array<Option, 2> options;
+    int optionCount = 0;
+    if (node.next < queueSize) {
+        int current = queue[node.next];
+        options[optionCount++] = Option{ current, node.next + 1, node.hold, false };
+        if (config.useHold && canHold) {
+            if (node.hold != -1 && node.hold != current) {
+                options[optionCount++] = Option{ node.hold, node.next + 1, current, true };
+            }
+            else if (node.hold == -1 && node.next + 1 < queueSize) {
+                options[optionCount++] = Option{ queue[node.next + 1], node.next + 2, current, true };
+            }
+        }
+    }
+    else if (config.useHold && canHold && node.hold != -1) {
+        options[optionCount++] = Option{ node.hold, node.next, -1, true };
+    }
+    if (optionCount == 0) return true;
+    std::vector<Placement>& placements = worker.placements[depth];
+
+    int zoneTop = GRID_HEIGHT - node.rowsLeft;
+    Child child;
+    for (int i = 0; i < optionCount; ++i) {
+        const Option& option = options[i];
+        placements.clear();
+        worker.generator.generate(node.board, Piece(option.type), placements, option.held);
+        for (const Placement& placement : placements) {
+            if (placement.piece.y < zoneTop) continue;
+            Node& next = child.node;
+            next.board = node.board;
+            int rows = lockOnBoard(next.board, placement.piece);
+            next.rowsLeft = node.rowsLeft - rows;
+            // Every piece still to come goes in whole, and one is spent per
+            // placement whether or not it passes through the hold slot; the
+            // held piece can still be placed last.
+            int empty = next.rowsLeft * GRID_WIDTH - filledCells(next.board, next.rowsLeft);
+            int piecesLeft = queueSize - option.next + (config.useHold && option.hold != -1 ? 1 : 0);
+            if (empty / 4 > piecesLeft) continue;
+            next.next = option.next;
+            next.hold = option.hold;
+            if (rows == 0) {
+                next.boardHash = node.boardHash;
+                for (const Cell& block : placement.piece.getBlocks()) {
+                    next.boardHash ^= keys.cell(block.x, block.y);
+                }
+            }
+            else {
+                next.boardHash = keys.board(next.board, GRID_HEIGHT - next.rowsLeft);
+            }
+            child.step.placement = placement;
+            child.step.rowsCleared = rows;
+            if (!visit(child)) return false;
+        }
+    }
+    return true;
+}
+
+bool PerfectClearSolver::searchRoot(const Node& root, Search& search, bool canHold, std::vector<PerfectClearStep>& out) {
+    Worker worker;
+    std::vector<Child> children;
+    expand(root, search, canHold, worker, 0, [&](const Child& child) {
+        children.push_back(child);
+        return true;
+    });
+
+    search.solvedRoot = NO_SOLUTION;
+    std::vector<std::vector<PerfectClearStep>> solutions(children.size());
+    auto searchChild = [&](int i) {
+        if (stopped(search, i)) return;
+        Worker taskWorker;
+        std::vector<PerfectClearStep>& steps = solutions[i];
+        if (searchFrom(children[i].node, search, i, taskWorker, 1, steps) != Outcome::Solved) return;
+        // Steps were collected on the way back up.
+        steps.push_back(children[i].step);
+        std::reverse(steps.begin(), steps.end());
+        int solved = search.solvedRoot;
+        while (i < solved && !search.solvedRoot.compare_exchange_weak(solved, i)) {
+        }
+    };
+    if (pool) {
+        pool->parallelFor(static_cast<int>(children.size()), searchChild);
+    }
+    else {
+        for (int i = 0; i < static_cast<int>(children.size()); ++i) {
+            searchChild(i);
+        }
+    }
+
+    int solved = search.solvedRoot;
+    if (solved == NO_SOLUTION) return false;
+    out = std::move(solutions[solved]);
+    return true;
+}
+
+PerfectClearSolver::Outcome PerfectClearSolver::searchFrom(const Node& node, Search& search, int root, Worker& worker,
+    int depth, std::vector<PerfectClearStep>& steps) {
+    if (node.rowsLeft == 0) return Outcome::Solved;
+    std::uint64_t hash = hashOf(node, search);
+    if (table.contains(hash)) return Outcome::Dead;
+    if (stopped(search, root)) return Outcome::Aborted;
+    if (search.nodes.fetch_add(1, std::memory_order_relaxed) >= config.maxNodes) {
+        search.outOfNodes = true;
+        return Outcome::Aborted;
+    }
+
+    Outcome outcome = Outcome::Dead;
+    expand(node, search, true, worker, depth, [&](const Child& child) {
+        Outcome result = searchFrom(child.node, search, root, worker, depth + 1, steps);
+        if (result == Outcome::Dead) return true;
+        if (result == Outcome::Solved) {
+            steps.push_back(child.step);
+        }
+        outcome = result;
+        return false;
+    });
+    // Only a full search proves anything; a stopped one is simply dropped.
+    if (outcome == Outcome::Dead) {
+        table.insert(hash);
+    }
+    return outcome;
+}
+
+std::uint64_t PerfectClearSolver::hashOf(const Node& node, const Search& search) const {
+    return node.boardHash ^ keys.hold(config.useHold ? node.hold : PIECE_TYPES) ^
+        search.remainingHashes[node.next] ^ keys.rowsLeft(node.rowsLeft);
+}
+
+bool PerfectClearSolver::stopped(const Search& search, int root) const {
+    return (search.cancel && search.cancel->load(std::memory_order_relaxed)) ||
+        search.outOfNodes.load(std::memory_order_relaxed) ||
+        search.solvedRoot.load(std::memory_order_relaxed) < root;
+}
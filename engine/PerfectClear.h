@@ -0,0 +1,171 @@
+#pragma once
+
+#include "MoveGenerator.h"
+#include "ThreadPool.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Random 64-bit keys whose XOR identifies a search position: one per board
+// cell, per type in the hold slot, per (offset, type) of the pieces still to
+// come and per number of rows left to clear. Locking a piece without clearing
+// a row changes a board's hash by four XORs.
+class ZobristKeys {
+public:
+    // The current piece plus the longest preview.
+    static const int MAX_QUEUE = PieceQueue::MAX_PREVIEW + 1;
+
+    ZobristKeys();
+
+    std::uint64_t cell(int x, int y) const { return cells[y][x]; }
+    // type -1 is an empty hold slot, PIECE_TYPES a search that never holds.
+    std::uint64_t hold(int type) const { return holds[type + 1]; }
+    // A piece of this type offset places from the front of the pieces to come.
+    std::uint64_t queued(int offset, int type) const { return queue[offset][type]; }
+    std::uint64_t queueLength(int length) const { return lengths[length]; }
+    std::uint64_t rowsLeft(int rows) const { return rowCounts[rows]; }
+    // XOR of the keys of the filled cells in rows firstRow and below.
+    std::uint64_t board(const Board& board, int firstRow = 0) const;
+
+private:
+    std::array<std::array<std::uint64_t, GRID_WIDTH>, GRID_HEIGHT> cells;
+    std::array<std::uint64_t, PIECE_TYPES + 2> holds;
+    std::array<std::array<std::uint64_t, PIECE_TYPES>, MAX_QUEUE> queue;
+    std::array<std::uint64_t, MAX_QUEUE + 1> lengths;
+    std::array<std::uint64_t, GRID_HEIGHT + 1> rowCounts;
+};
+
+// The hashes of positions proven to have no perfect clear, shared by every
+// search thread without locks. An entry is the whole 64-bit hash, written with
+// one atomic store, so a reader sees an entry complete or not at all. Buckets
+// of four entries fill with compare-and-swap; once a bucket is full a new
+// entry overwrites one of its four, so the table never grows past 2^bits
+// entries. Two positions sharing a hash would wrongly share a verdict; at
+// 64 bits that is not expected in any search this table could hold.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(int bits);
+
+    void clear();
+    bool contains(std::uint64_t hash) const;
+    void insert(std::uint64_t hash);
+    std::size_t capacity() const { return (bucketMask + 1) * BUCKET_SIZE; }
+
+private:
+    static const int BUCKET_SIZE = 4;
+    // 0 marks an empty entry, so a zero hash is stored as 1.
+    static std::uint64_t entryOf(std::uint64_t hash) { return hash ? hash : 1; }
+
+    std::unique_ptr<std::atomic<std::uint64_t>[]> entries;
+    std::size_t bucketMask;
+};
+
+struct PerfectClearConfig {
+    // Longest solution searched for, in pieces; never more than are known
+    // (the current piece, the previews and the held piece).
+    int maxPieces = 7;
+    // Rows from the floor the cleared stack may take up.
+    int maxHeight = 4;
+    // Positions expanded before solve() gives up with Unknown.
+    std::uint64_t maxNodes = 1000000;
+    bool useHold = true;
+    // The transposition table holds 2^tableBits entries of 8 bytes.
+    int tableBits = 20;
+};
+
+enum class PerfectClearStatus {
+    Found,
+    // No perfect clear within maxPieces and maxHeight.
+    None,
+    // The node budget ran out or the search was cancelled first.
+    Unknown
+};
+
+// One piece of a solution: where it goes on the board left by the steps
+// before it (with their rows cleared) and how many rows it clears in turn.
+// placement.hold means Input::Hold is pressed before placing it.
+struct PerfectClearStep {
+    Placement placement;
+    int rowsCleared = 0;
+};
+
+struct PerfectClearResult {
+    PerfectClearStatus status = PerfectClearStatus::None;
+    std::vector<PerfectClearStep> steps;
+    std::uint64_t nodes = 0;
+};
+
+// Finds the shortest sequence of placements of the known pieces that leaves
+// the board empty, or proves there is none within the configured number of
+// pieces. Target heights are tried from the lowest that fits the stack, so the
+// first solution found uses the fewest pieces; for a height, every piece has
+// to lie inside that many bottom rows. Placements come from MoveGenerator, so
+// every step is reachable with the engine's moves.
+//
+// The search is depth first. Each position is hashed with ZobristKeys (board,
+// hold, the pieces still to come and the rows left), and positions proven
+// dead go into a TranspositionTable, so orders of placement that meet again
+// are expanded once. Positions are judged only by what is still to come, so
+// the table stays valid from one solve() to the next and a game's successive
+// searches reuse it. The placements of the first piece are searched in
+// parallel on the thread pool, all sharing the table; the lowest-numbered
+// first placement that leads to a solution wins, so the answer does not depend
+// on timing unless the node budget runs out.
+class PerfectClearSolver {
+public:
+    // The most pieces a solution can place: the queue and the held piece.
+    static const int MAX_PIECES = ZobristKeys::MAX_QUEUE + 1;
+
+    explicit PerfectClearSolver(const PerfectClearConfig& config = PerfectClearConfig(), ThreadPool* pool = nullptr);
+
+    // From the engine's board with its current piece, previews and hold.
+    PerfectClearResult solve(const TetrisEngine& engine, const std::atomic<bool>* cancel = nullptr);
+    // queue[0] is the piece to place now and the rest follow in order; hold is
+    // the held type or -1, and canHold is false once hold was used this piece.
+    // Once the caller sets *cancel, from any thread and even before the search
+    // starts, solve() returns Unknown soon.
+    PerfectClearResult solve(const Board& board, const std::vector<int>& queue, int hold, bool canHold,
+        const std::atomic<bool>* cancel = nullptr);
+
+    void clearTable() { table.clear(); }
+
+private:
+    struct Node {
+        Board board;
+        std::uint64_t boardHash = 0;
+        // Index in the queue of the piece to place now.
+        int next = 0;
+        int hold = -1;
+        int rowsLeft = 0;
+    };
+    struct Child {
+        Node node;
+        PerfectClearStep step;
+    };
+    enum class Outcome {
+        Solved,
+        Dead,
+        Aborted
+    };
+    struct Search;
+    struct Worker;
+
+    // Calls visit(child) for every position one placement away until it
+    // returns false; false if it was stopped.
+    template <typename Visit>
+    bool expand(const Node& node, const Search& search, bool canHold, Worker& worker, int depth, Visit visit) const;
+    // Searches every first placement from root; on success out holds the steps.
+    bool searchRoot(const Node& root, Search& search, bool canHold, std::vector<PerfectClearStep>& out);
+    Outcome searchFrom(const Node& node, Search& search, int root, Worker& worker, int depth,
+        std::vector<PerfectClearStep>& steps);
+    std::uint64_t hashOf(const Node& node, const Search& search) const;
+    bool stopped(const Search& search, int root) const;
+
+    PerfectClearConfig config;
+    ThreadPool* pool;
+    ZobristKeys keys;
+    TranspositionTable table;
+};
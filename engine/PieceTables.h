@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Board.h"
+
+#include <algorithm>
+#include <array>
+
+const int PIECE_TYPES = 7;
+
+struct Cell {
+    int x, y;
+};
+
+// Per-rotation data derived at compile time from the shape patterns below.
+// columnBottom holds the lowest occupied row offset of each column (-1 if empty).
+struct PieceShape {
+    std::array<Cell, 4> cells;
+    std::array<RowMask, 4> rowMasks;
+    int width;
+    int height;
+    std::array<int, 4> columnBottom;
+};
+
+constexpr PieceShape makeShape(const char* r0, const char* r1 = "", const char* r2 = "", const char* r3 = "") {
+    PieceShape shape{};
+    const char* pattern[4] = { r0, r1, r2, r3 };
+    for (int j = 0; j < 4; ++j) {
+        shape.columnBottom[j] = -1;
+    }
+
+    int count = 0;
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; pattern[i][j] != '\0'; ++j) {
+            if (pattern[i][j] != '#') continue;
+            shape.cells[count++] = Cell{ j, i };
+            shape.rowMasks[i] |= static_cast<RowMask>(1u << j);
+            shape.width = std::max(shape.width, j + 1);
+            shape.height = std::max(shape.height, i + 1);
+            shape.columnBottom[j] = i;
+        }
+    }
+    return shape;
+}
+
+// Rotation states in clockwise order. Types with fewer distinct rotations repeat
+// them so that PIECE_SHAPES[type][rotation & 3] is valid for any rotation.
+const std::array<int, PIECE_TYPES> ROTATION_COUNTS = { 2, 4, 4, 1, 2, 4, 2 };
+
+constexpr std::array<std::array<PieceShape, 4>, PIECE_TYPES> PIECE_SHAPES = { {
+    // I
+    { { makeShape("####"), makeShape("#", "#", "#", "#"),
+        makeShape("####"), makeShape("#", "#", "#", "#") } },
+    // J
+    { { makeShape("#..", "###"), makeShape("##", "#.", "#."),
+        makeShape("###", "..#"), makeShape(".#", ".#", "##") } },
+    // L
+    { { makeShape("..#", "###"), makeShape("#.", "#.", "##"),
+        makeShape("###", "#.."), makeShape("##", ".#", ".#") } },
+    // O
+    { { makeShape("##", "##"), makeShape("##", "##"),
+        makeShape("##", "##"), makeShape("##", "##") } },
+    // S
+    { { makeShape(".##", "##."), makeShape("#.", "##", ".#"),
+        makeShape(".##", "##."), makeShape("#.", "##", ".#") } },
+    // T
+    { { makeShape(".#.", "###"), makeShape("#.", "##", "#."),
+        makeShape("###", ".#."), makeShape(".#", "##", ".#") } },
+    // Z
+    { { makeShape("##.", ".##"), makeShape(".#", "##", "#."),
+        makeShape("##.", ".##"), makeShape(".#", "##", "#.") } }
+} };
+
+constexpr bool allShapesHaveFourCells() {
+    for (const auto& rotations : PIECE_SHAPES) {
+        for (const auto& shape : rotations) {
+            int count = 0;
+            for (RowMask mask : shape.rowMasks) {
+                for (; mask; mask &= mask - 1) ++count;
+            }
+            if (count != 4) return false;
+        }
+    }
+    return true;
+}
+
+static_assert(allShapesHaveFourCells(), "every rotation must have exactly four cells");
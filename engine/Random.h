@@ -0,0 +1,137 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// xoshiro256** seeded through splitmix64. Every game owns its own generator, so
+// a seed fully determines the piece sequence on every platform and build.
+class Rng {
+public:
+    explicit Rng(std::uint64_t seed = 0) {
+        reseed(seed);
+    }
+
+    void reseed(std::uint64_t seed) {
+        for (auto& word : state) {
+            seed += 0x9E3779B97F4A7C15ull;
+            std::uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    std::uint64_t next() {
+        std::uint64_t result = rotl(state[1] * 5, 7) * 9;
+        std::uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+
+    // Uniform in [0, bound) without modulo bias.
+    std::uint32_t nextBelow(std::uint32_t bound) {
+        std::uint32_t threshold = static_cast<std::uint32_t>(-bound) % bound;
+        for (;;) {
+            std::uint32_t value = static_cast<std::uint32_t>(next() >> 32);
+            if (value >= threshold) return value % bound;
+        }
+    }
+
+    // Uniform in [0, 1).
+    float nextFloat() {
+        return (next() >> 40) * (1.0f / 16777216.0f);
+    }
+
+private:
+    static std::uint64_t rotl(std::uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    std::array<std::uint64_t, 4> state;
+};
+
+// Standard 7-bag randomizer: each run of seven pieces is a shuffled permutation
+// of all seven types. The shuffle is done here rather than with std::shuffle,
+// whose output differs between standard library implementations.
+class SevenBag {
+public:
+    explicit SevenBag(std::uint64_t seed = 0) {
+        reset(seed);
+    }
+
+    void reset(std::uint64_t seed) {
+        rng.reseed(seed);
+        index = static_cast<int>(bag.size());
+    }
+
+    int next() {
+        if (index == static_cast<int>(bag.size())) {
+            refill();
+        }
+        return bag[index++];
+    }
+
+private:
+    void refill() {
+        for (int i = 0; i < static_cast<int>(bag.size()); ++i) {
+            bag[i] = i;
+        }
+        for (int i = static_cast<int>(bag.size()) - 1; i > 0; --i) {
+            int j = static_cast<int>(rng.nextBelow(static_cast<std::uint32_t>(i + 1)));
+            int swapped = bag[i];
+            bag[i] = bag[j];
+            bag[j] = swapped;
+        }
+        index = 0;
+    }
+
+    Rng rng;
+    std::array<int, 7> bag;
+    int index;
+};
+
+// Fixed-size ring of the upcoming piece types, refilled from a SevenBag.
+class PieceQueue {
+public:
+    static const int MAX_PREVIEW = 6;
+
+    void reset(std::uint64_t seed, int previewCount) {
+        bag.reset(seed);
+        count = previewCount < 1 ? 1 : (previewCount > MAX_PREVIEW ? MAX_PREVIEW : previewCount);
+        head = 0;
+        for (int i = 0; i < count; ++i) {
+            pieces[i] = bag.next();
+        }
+    }
+
+    // Takes the front piece and appends a fresh one at the back.
+    int pop() {
+        int type = pieces[head];
+        pieces[head] = bag.next();
+        if (++head == count) {
+            head = 0;
+        }
+        return type;
+    }
+
+    // i must be less than size().
+    int peek(int i) const {
+        int index = head + i;
+        return pieces[index < count ? index : index - count];
+    }
+
+    int size() const {
+        return count;
+    }
+
+private:
+    SevenBag bag;
+    std::array<int, MAX_PREVIEW> pieces{};
+    int head = 0;
+    int count = 1;
+};
@@ -0,0 +1,137 @@
+#include "Replay.h"
+#include "TetrisEngine.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+namespace {
+    const char MAGIC[4] = { 'T', 'R', 'P', 'L' };
+    const std::uint64_t FORMAT_VERSION = 1;
+
+    void writeVarint(std::vector<std::uint8_t>& out, std::uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<std::uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<std::uint8_t>(value));
+    }
+
+    bool readVarint(const std::vector<std::uint8_t>& in, std::size_t& pos, std::uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && pos < in.size(); shift += 7) {
+            std::uint8_t byte = in[pos++];
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+}
+
+bool Replay::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    std::vector<std::uint8_t> in((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    if (in.size() < sizeof(MAGIC) + 8 || !std::equal(MAGIC, MAGIC + 4, in.begin())) return false;
+    std::size_t pos = sizeof(MAGIC);
+
+    std::uint64_t value;
+    if (!readVarint(in, pos, value) || value != FORMAT_VERSION || pos + 8 > in.size()) return false;
+    seed = 0;
+    for (int i = 0; i < 8; ++i) {
+        seed |= static_cast<std::uint64_t>(in[pos++]) << (8 * i);
+    }
+    if (!readVarint(in, pos, value)) return false;
+    previewCount = static_cast<int>(value);
+
+    events.clear();
+    std::uint32_t timeMs = 0;
+    for (;;) {
+        if (!readVarint(in, pos, value)) return false;
+        timeMs += static_cast<std::uint32_t>(value >> 3);
+        std::uint8_t code = static_cast<std::uint8_t>(value & 7);
+        if (code == ReplayEvent::END) break;
+        events.push_back(ReplayEvent{ timeMs, code });
+    }
+
+    std::uint64_t footer[4];
+    for (auto& field : footer) {
+        if (!readVarint(in, pos, field)) return false;
+    }
+    finalScore = static_cast<int>(footer[0]);
+    finalLines = static_cast<int>(footer[1]);
+    finalLevel = static_cast<int>(footer[2]);
+    durationMs = static_cast<std::uint32_t>(footer[3]);
+    return true;
+}
+
+void ReplayRecorder::begin(std::uint64_t seed, int previewCount) {
+    this->seed = seed;
+    this->previewCount = previewCount;
+    bytes.clear();
+    lastTimeMs = 0;
+    events = 0;
+}
+
+void ReplayRecorder::recordInput(Input input, std::uint32_t timeMs) {
+    record(static_cast<std::uint8_t>(input), timeMs);
+}
+
+void ReplayRecorder::recordGravity(std::uint32_t timeMs) {
+    record(ReplayEvent::GRAVITY, timeMs);
+}
+
+void ReplayRecorder::record(std::uint8_t code, std::uint32_t timeMs) {
+    std::uint64_t delta = timeMs >= lastTimeMs ? timeMs - lastTimeMs : 0;
+    lastTimeMs = timeMs >= lastTimeMs ? timeMs : lastTimeMs;
+    writeVarint(bytes, (delta << 3) | code);
+    events++;
+}
+
+bool ReplayRecorder::save(const std::string& path, int finalScore, int finalLines, int finalLevel, std::uint32_t durationMs) const {
+    std::vector<std::uint8_t> out(MAGIC, MAGIC + sizeof(MAGIC));
+    writeVarint(out, FORMAT_VERSION);
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<std::uint8_t>(seed >> (8 * i)));
+    }
+    writeVarint(out, static_cast<std::uint64_t>(previewCount));
+    out.insert(out.end(), bytes.begin(), bytes.end());
+    writeVarint(out, ReplayEvent::END);
+    writeVarint(out, static_cast<std::uint64_t>(finalScore));
+    writeVarint(out, static_cast<std::uint64_t>(finalLines));
+    writeVarint(out, static_cast<std::uint64_t>(finalLevel));
+    writeVarint(out, durationMs);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+    file.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+    return file.good();
+}
+
+void ReplayPlayer::start(TetrisEngine& engine) {
+    EngineConfig config;
+    config.seed = replay.seed;
+    config.previewCount = replay.previewCount;
+    position = 0;
+    engine.reset(config);
+}
+
+bool ReplayPlayer::playNext(TetrisEngine& engine, std::uint32_t timeMs, StepEvents& events) {
+    if (isFinished() || replay.events[position].timeMs > timeMs) return false;
+
+    const ReplayEvent& event = replay.events[position++];
+    if (event.code == ReplayEvent::GRAVITY) {
+        events = engine.applyGravity();
+    }
+    else {
+        events = engine.applyInput(static_cast<Input>(event.code));
+    }
+    return true;
+}
+
+void ReplayPlayer::playToEnd(TetrisEngine& engine) {
+    StepEvents events;
+    while (playNext(engine, UINT32_MAX, events)) {
+    }
+}
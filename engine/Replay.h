@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class TetrisEngine;
+struct StepEvents;
+enum class Input : std::uint8_t;
+
+// A replay is the game seed plus every engine input and gravity tick, each
+// stamped with the game time it happened at.
+//
+// File layout (all integers are LEB128 varints unless noted):
+//   "TRPL" magic, format version, seed (8 bytes little-endian), preview count,
+//   events as ((milliseconds since previous event) << 3 | code),
+//   END code, then final score, lines, level and duration in milliseconds.
+// Codes 0-5 are the Input values, GRAVITY is a gravity tick. Most events take
+// one or two bytes.
+struct ReplayEvent {
+    static const std::uint8_t GRAVITY = 6;
+    static const std::uint8_t END = 7;
+
+    std::uint32_t timeMs;
+    std::uint8_t code;
+};
+
+struct Replay {
+    std::uint64_t seed = 0;
+    int previewCount = 1;
+    std::vector<ReplayEvent> events;
+    int finalScore = 0;
+    int finalLines = 0;
+    int finalLevel = 0;
+    std::uint32_t durationMs = 0;
+
+    // Returns false if the file is missing, truncated or not a replay.
+    bool load(const std::string& path);
+};
+
+class ReplayRecorder {
+public:
+    void begin(std::uint64_t seed, int previewCount);
+    void recordInput(Input input, std::uint32_t timeMs);
+    void recordGravity(std::uint32_t timeMs);
+    bool save(const std::string& path, int finalScore, int finalLines, int finalLevel, std::uint32_t durationMs) const;
+
+    std::size_t eventCount() const { return events; }
+
+private:
+    void record(std::uint8_t code, std::uint32_t timeMs);
+
+    std::vector<std::uint8_t> bytes;
+    std::uint64_t seed = 0;
+    int previewCount = 1;
+    std::uint32_t lastTimeMs = 0;
+    std::size_t events = 0;
+};
+
+// Feeds a replay's events into an engine, either all at once (headless runs)
+// or up to a playback time (rendered playback at any speed).
+class ReplayPlayer {
+public:
+    explicit ReplayPlayer(const Replay& replay) : replay(replay), position(0) {}
+
+    // Resets the engine to the replay's seed and preview count.
+    void start(TetrisEngine& engine);
+
+    // Applies the next event if it is due at or before timeMs.
+    bool playNext(TetrisEngine& engine, std::uint32_t timeMs, StepEvents& events);
+
+    // Applies every remaining event as fast as possible.
+    void playToEnd(TetrisEngine& engine);
+
+    bool isFinished() const { return position == replay.events.size(); }
+
+private:
+    const Replay& replay;
+    std::size_t position;
+};
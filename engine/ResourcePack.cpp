@@ -0,0 +1,230 @@
+#include "ResourcePack.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const char MAGIC[4] = { 'T', 'P', 'A', 'K' };
+    const std::uint32_t FORMAT_VERSION = 1;
+    const std::size_t HEADER_SIZE = 16;
+    const std::size_t DATA_ALIGNMENT = 16;
+
+    std::array<std::uint32_t, 256> makeCrcTable() {
+        std::array<std::uint32_t, 256> table{};
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            std::uint32_t value = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                value = (value >> 1) ^ (0xEDB88320u & (0u - (value & 1u)));
+            }
+            table[i] = value;
+        }
+        return table;
+    }
+
+    std::uint32_t readU32(const std::uint8_t* in) {
+        return static_cast<std::uint32_t>(in[0]) | static_cast<std::uint32_t>(in[1]) << 8 |
+            static_cast<std::uint32_t>(in[2]) << 16 | static_cast<std::uint32_t>(in[3]) << 24;
+    }
+
+    std::uint64_t readU64(const std::uint8_t* in) {
+        return readU32(in) | static_cast<std::uint64_t>(readU32(in + 4)) << 32;
+    }
+
+    void writeU32(std::vector<std::uint8_t>& out, std::uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            out.push_back(static_cast<std::uint8_t>(value >> (i * 8)));
+        }
+    }
+
+    void writeU64(std::vector<std::uint8_t>& out, std::uint64_t value) {
+        writeU32(out, static_cast<std::uint32_t>(value));
+        writeU32(out, static_cast<std::uint32_t>(value >> 32));
+    }
+
+    std::uint64_t alignUp(std::uint64_t value) {
+        return (value + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+    }
+}
+
+std::uint32_t crc32(const void* data, std::size_t size, std::uint32_t crc) {
+    static const std::array<std::uint32_t, 256> table = makeCrcTable();
+    const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+    crc = ~crc;
+    for (std::size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const std::string& path) {
+    close();
+    fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        fileHandle = nullptr;
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+        close();
+        return false;
+    }
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mappingHandle) {
+        close();
+        return false;
+    }
+    bytes = static_cast<const std::uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (!bytes) {
+        close();
+        return false;
+    }
+    length = static_cast<std::size_t>(fileSize.QuadPart);
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes) UnmapViewOfFile(bytes);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle) CloseHandle(fileHandle);
+    bytes = nullptr;
+    length = 0;
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+}
+#else
+bool MappedFile::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the descriptor is closed.
+    ::close(fd);
+    if (mapping == MAP_FAILED) return false;
+    bytes = static_cast<const std::uint8_t*>(mapping);
+    length = static_cast<std::size_t>(info.st_size);
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes) munmap(const_cast<std::uint8_t*>(bytes), length);
+    bytes = nullptr;
+    length = 0;
+}
+#endif
+
+bool ResourcePack::open(const std::string& path) {
+    entries.clear();
+    error.clear();
+    if (!file.open(path)) return fail("cannot map " + path);
+
+    const std::uint8_t* in = file.data();
+    std::size_t size = file.size();
+    if (size < HEADER_SIZE || std::memcmp(in, MAGIC, sizeof(MAGIC)) != 0) return fail(path + " is not a resource pack");
+    if (readU32(in + 4) != FORMAT_VERSION) return fail(path + " has an unsupported format version");
+    std::uint32_t count = readU32(in + 8);
+    std::uint32_t indexCrc = readU32(in + 12);
+
+    std::size_t pos = HEADER_SIZE;
+    for (std::uint32_t i = 0; i < count; ++i) {
+        if (size - pos < 4) return fail(path + " has a truncated index");
+        std::uint32_t nameLength = readU32(in + pos);
+        pos += 4;
+        if (size - pos < nameLength + 20ull) return fail(path + " has a truncated index");
+        PackEntry entry;
+        entry.name.assign(reinterpret_cast<const char*>(in + pos), nameLength);
+        pos += nameLength;
+        entry.offset = readU64(in + pos);
+        entry.size = readU64(in + pos + 8);
+        entry.crc = readU32(in + pos + 16);
+        pos += 20;
+        if (entry.offset > size || entry.size > size - entry.offset) {
+            return fail(path + ": " + entry.name + " lies outside the file");
+        }
+        entries.push_back(entry);
+    }
+    if (crc32(in + HEADER_SIZE, pos - HEADER_SIZE) != indexCrc) return fail(path + " has a corrupt index");
+
+    std::sort(entries.begin(), entries.end(), [](const PackEntry& a, const PackEntry& b) { return a.name < b.name; });
+    return true;
+}
+
+const PackEntry* ResourcePack::find(const std::string& name) const {
+    auto it = std::lower_bound(entries.begin(), entries.end(), name,
+        [](const PackEntry& entry, const std::string& key) { return entry.name < key; });
+    return it != entries.end() && it->name == name ? &*it : nullptr;
+}
+
+bool ResourcePack::verify(const PackEntry& entry) const {
+    return crc32(data(entry), static_cast<std::size_t>(entry.size)) == entry.crc;
+}
+
+bool ResourcePack::fail(const std::string& message) {
+    file.close();
+    entries.clear();
+    error = message;
+    return false;
+}
+
+bool ResourcePack::write(const std::string& path, const std::vector<Source>& sources) {
+    std::vector<std::uint8_t> index;
+    std::uint64_t indexSize = 0;
+    for (const Source& source : sources) {
+        indexSize += 4 + source.name.size() + 20;
+    }
+
+    std::uint64_t offset = alignUp(HEADER_SIZE + indexSize);
+    std::vector<std::uint64_t> offsets;
+    for (const Source& source : sources) {
+        writeU32(index, static_cast<std::uint32_t>(source.name.size()));
+        index.insert(index.end(), source.name.begin(), source.name.end());
+        writeU64(index, offset);
+        writeU64(index, source.bytes.size());
+        writeU32(index, crc32(source.bytes.data(), source.bytes.size()));
+        offsets.push_back(offset);
+        offset = alignUp(offset + source.bytes.size());
+    }
+
+    std::vector<std::uint8_t> header(MAGIC, MAGIC + sizeof(MAGIC));
+    writeU32(header, FORMAT_VERSION);
+    writeU32(header, static_cast<std::uint32_t>(sources.size()));
+    writeU32(header, crc32(index.data(), index.size()));
+
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) return false;
+    out.write(reinterpret_cast<const char*>(header.data()), header.size());
+    out.write(reinterpret_cast<const char*>(index.data()), index.size());
+    std::uint64_t written = header.size() + index.size();
+    const char padding[DATA_ALIGNMENT] = {};
+    for (std::size_t i = 0; i < sources.size(); ++i) {
+        out.write(padding, offsets[i] - written);
+        out.write(sources[i].bytes.data(), sources[i].bytes.size());
+        written = offsets[i] + sources[i].bytes.size();
+    }
+    return out.good();
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// All game assets in one file, memory-mapped at startup so each asset is a
+// pointer into the mapping rather than a separate open and read.
+//
+// File layout (integers little-endian):
+//   "TPAK" magic, u32 format version, u32 entry count, u32 CRC-32 of the index,
+//   index: per entry u32 name length, name bytes, u64 offset, u64 size, u32 CRC-32,
+//   then the entry data, each entry starting on a 16-byte boundary.
+// Offsets are from the start of the file.
+
+// CRC-32 (IEEE 802.3), continuing from a previous result when crc is given.
+std::uint32_t crc32(const void* data, std::size_t size, std::uint32_t crc = 0);
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    const std::uint8_t* data() const { return bytes; }
+    std::size_t size() const { return length; }
+
+private:
+    const std::uint8_t* bytes = nullptr;
+    std::size_t length = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
+
+struct PackEntry {
+    std::string name;
+    std::uint64_t offset;
+    std::uint64_t size;
+    std::uint32_t crc;
+};
+
+class ResourcePack {
+public:
+    // Maps the pack and checks its header and index; on failure getError() says why.
+    bool open(const std::string& path);
+    bool isOpen() const { return file.data() != nullptr; }
+
+    // nullptr when the pack has no entry of that name.
+    const PackEntry* find(const std::string& name) const;
+    const void* data(const PackEntry& entry) const { return file.data() + entry.offset; }
+    // Recomputes the entry's CRC-32 over the mapped bytes.
+    bool verify(const PackEntry& entry) const;
+
+    const std::vector<PackEntry>& getEntries() const { return entries; }
+    const std::string& getError() const { return error; }
+
+    // Writes a pack holding the given files, in the given order.
+    struct Source {
+        std::string name;
+        std::vector<char> bytes;
+    };
+    static bool write(const std::string& path, const std::vector<Source>& sources);
+
+private:
+    bool fail(const std::string& message);
+
+    MappedFile file;
+    std::vector<PackEntry> entries;
+    std::string error;
+};
@@ -0,0 +1,215 @@
+#include "TetrisEngine.h"
+
+#include <algorithm>
+
+bool isValidPosition(const Piece& piece, const Board& board) {
+    const PieceShape& shape = piece.shape();
+    if (piece.x < 0 || piece.x + shape.width > GRID_WIDTH || piece.y + shape.height > GRID_HEIGHT) return false;
+    return !board.collides(shape.rowMasks.data(), shape.height, piece.x, piece.y);
+}
+
+int dropDistance(const Piece& piece, const Board& board) {
+    // When every column's lowest piece cell is above that column's stack, the
+    // landing row follows from the column heights alone.
+    const PieceShape& shape = piece.shape();
+    int distance = GRID_HEIGHT;
+    for (int j = 0; j < shape.width; ++j) {
+        int cellRow = piece.y + shape.columnBottom[j];
+        int surfaceRow = GRID_HEIGHT - board.heights[piece.x + j];
+        if (cellRow >= surfaceRow) {
+            distance = -1;
+            break;
+        }
+        distance = std::min(distance, surfaceRow - 1 - cellRow);
+    }
+    if (distance >= 0) return distance;
+
+    // The piece is tucked under an overhang: step down with mask tests instead.
+    distance = 0;
+    while (piece.y + distance + shape.height < GRID_HEIGHT &&
+        !board.collides(shape.rowMasks.data(), shape.height, piece.x, piece.y + distance + 1)) {
+        distance++;
+    }
+    return distance;
+}
+
+TetrisEngine::TetrisEngine(const EngineConfig& config) : config(config) {
+    reset(config.seed);
+}
+
+void TetrisEngine::reset(const EngineConfig& config) {
+    this->config = config;
+    reset(config.seed);
+}
+
+void TetrisEngine::reset(std::uint64_t seed) {
+    this->seed = seed;
+    queue.reset(seed, config.previewCount);
+    board.clear();
+    boardRevision++;
+    score = 0;
+    level = 1;
+    linesCleared = 0;
+    fallTime = INITIAL_FALL_TIME;
+    currentTime = 0.0f;
+    elapsedTime = 0.0;
+    gameOver = false;
+    canHold = true;
+    currentPiece = spawnPiece();
+    holdPiece = Piece();
+}
+
+void TetrisEngine::loadBoard(const Board& board) {
+    this->board = board;
+    boardRevision++;
+    gameOver = !isValidPosition(currentPiece, board);
+}
+
+Piece TetrisEngine::spawnPiece() {
+    return Piece(queue.pop());
+}
+
+StepEvents TetrisEngine::applyInput(Input input) {
+    StepEvents events;
+    if (gameOver) return events;
+    if (recorder) recorder->recordInput(input, getElapsedMs());
+
+    switch (input) {
+    case Input::MoveLeft:
+        events.moved = tryMove(-1, 0, 0);
+        break;
+    case Input::MoveRight:
+        events.moved = tryMove(1, 0, 0);
+        break;
+    case Input::SoftDrop:
+        events.moved = tryMove(0, 1, 0);
+        break;
+    case Input::Rotate:
+        events.rotated = tryMove(0, 0, 1);
+        break;
+    case Input::HardDrop:
+        hardDrop(events);
+        break;
+    case Input::Hold:
+        hold(events);
+        break;
+    }
+    return events;
+}
+
+StepEvents TetrisEngine::step(float deltaTime) {
+    StepEvents events;
+    if (gameOver) return events;
+
+    elapsedTime += deltaTime;
+    currentTime += deltaTime;
+    if (currentTime >= fallTime) {
+        // Carry the remainder over so the fall rate does not depend on the step size.
+        currentTime -= fallTime;
+        events = applyGravity();
+    }
+    return events;
+}
+
+StepEvents TetrisEngine::applyGravity() {
+    StepEvents events;
+    if (gameOver) return events;
+    if (recorder) recorder->recordGravity(getElapsedMs());
+
+    if (tryMove(0, 1, 0)) {
+        events.moved = true;
+    }
+    else {
+        lockPiece(events);
+    }
+    return events;
+}
+
+Piece TetrisEngine::getGhostPiece() const {
+    Piece ghost = currentPiece;
+    ghost.y += dropDistance(currentPiece, board);
+    return ghost;
+}
+
+bool TetrisEngine::tryMove(int dx, int dy, int rotations) {
+    Piece temp = currentPiece;
+    temp.x += dx;
+    temp.y += dy;
+    temp.rotation = (temp.rotation + rotations) % ROTATION_COUNTS[temp.type];
+    if (!isValidPosition(temp, board)) return false;
+
+    currentPiece = temp;
+    return true;
+}
+
+void TetrisEngine::hold(StepEvents& events) {
+    if (!canHold) return;
+
+    if (holdPiece.type == -1) {
+        holdPiece = currentPiece;
+        currentPiece = spawnPiece();
+    }
+    else {
+        std::swap(holdPiece, currentPiece);
+        currentPiece.x = SPAWN_X;
+        currentPiece.y = SPAWN_Y;
+        currentPiece.rotation = 0;
+    }
+
+    canHold = false;
+    events.held = true;
+}
+
+void TetrisEngine::hardDrop(StepEvents& events) {
+    currentPiece = getGhostPiece();
+    lockPiece(events);
+    events.hardDropped = true;
+    currentTime = 0.0f;
+}
+
+void TetrisEngine::lockPiece(StepEvents& events) {
+    events.locked = true;
+    events.lockedType = currentPiece.type;
+    events.lockedCells = currentPiece.getBlocks();
+    for (const auto& block : events.lockedCells) {
+        if (block.y >= 0) {
+            board.setCell(block.x, block.y, currentPiece.type + 1);
+        }
+    }
+    boardRevision++;
+
+    checkRows(events, currentPiece.y, currentPiece.y + currentPiece.shape().height - 1);
+
+    currentPiece = spawnPiece();
+    canHold = true;
+    if (!isValidPosition(currentPiece, board)) {
+        gameOver = true;
+        events.gameOver = true;
+    }
+}
+
+void TetrisEngine::checkRows(StepEvents& events, int firstRow, int lastRow) {
+    events.lineClear = board.clearFullRows(firstRow, lastRow);
+    int rowsCleared = events.lineClear.count;
+
+    if (rowsCleared > 0) {
+        score += lineClearScore(rowsCleared, level);
+        linesCleared += rowsCleared;
+        level = levelForLines(linesCleared);
+        fallTime = std::max(0.1f, INITIAL_FALL_TIME - (level - 1) * 0.05f);
+    }
+}
+
+int lineClearScore(int rows, int level) {
+    switch (rows) {
+    case 1: return 100 * level;
+    case 2: return 300 * level;
+    case 3: return 500 * level;
+    case 4: return 800 * level;
+    default: return 0;
+    }
+}
+
+int levelForLines(int linesCleared) {
+    return 1 + linesCleared / 10;
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "Board.h"
+#include "PieceTables.h"
+#include "Random.h"
+#include "Replay.h"
+
+#include <array>
+#include <cstdint>
+
+const float INITIAL_FALL_TIME = 0.5f;
+const int SPAWN_X = 4;
+const int SPAWN_Y = 0;
+
+struct Piece {
+    int x, y;
+    int rotation;
+    int type;
+
+    explicit Piece(int type = -1) : x(SPAWN_X), y(SPAWN_Y), rotation(0), type(type) {}
+
+    const PieceShape& shape() const {
+        return PIECE_SHAPES[type][rotation & 3];
+    }
+
+    std::array<Cell, 4> getBlocks() const {
+        std::array<Cell, 4> blocks;
+        const auto& cells = shape().cells;
+        for (size_t i = 0; i < cells.size(); ++i) {
+            blocks[i] = Cell{ x + cells[i].x, y + cells[i].y };
+        }
+        return blocks;
+    }
+};
+
+bool isValidPosition(const Piece& piece, const Board& board);
+
+// Rows the piece can fall from its current (valid) position before landing.
+int dropDistance(const Piece& piece, const Board& board);
+
+// Points for clearing rows (0-4) with one piece at level. TetrisEngine,
+// BatchEngine and the tools all score through these two.
+int lineClearScore(int rows, int level);
+
+// The level a game is on once linesCleared rows are gone.
+int levelForLines(int linesCleared);
+
+enum class Input : std::uint8_t {
+    MoveLeft,
+    MoveRight,
+    SoftDrop,
+    Rotate,
+    HardDrop,
+    Hold
+};
+
+// What happened during one applyInput/step call, so a front end can play sounds
+// and spawn effects without inspecting the board itself.
+struct StepEvents {
+    bool moved = false;
+    bool rotated = false;
+    bool held = false;
+    bool hardDropped = false;
+    bool locked = false;
+    bool gameOver = false;
+
+    int lockedType = -1;
+    std::array<Cell, 4> lockedCells{};
+
+    LineClear lineClear;
+
+    bool pieceChanged() const {
+        return moved || rotated || held || locked;
+    }
+};
+
+struct EngineConfig {
+    std::uint64_t seed = 0;
+    // Upcoming pieces visible to the player (and to lookahead), up to PieceQueue::MAX_PREVIEW.
+    int previewCount = 4;
+};
+
+// Game rules with no rendering, audio or windowing dependency. A front end feeds
+// it player inputs and elapsed time and reacts to the returned StepEvents.
+class TetrisEngine {
+public:
+    explicit TetrisEngine(const EngineConfig& config = EngineConfig());
+
+    // Starts a new game whose piece sequence is fully determined by seed.
+    void reset(std::uint64_t seed);
+    // Same, but also replaces the configuration (e.g. a replay's preview count).
+    void reset(const EngineConfig& config);
+    // Replaces the locked cells, e.g. to start from a prepared position.
+    void loadBoard(const Board& board);
+    StepEvents applyInput(Input input);
+    // Advances the fall timer. Meant to be called with a fixed step much shorter
+    // than the fall time; at most one gravity tick happens per call.
+    StepEvents step(float deltaTime);
+    // One gravity tick: the piece falls a row or locks. step() calls this when
+    // the fall timer expires; replays call it directly.
+    StepEvents applyGravity();
+
+    // Every input and gravity tick is passed to the recorder until it is reset to null.
+    void setRecorder(ReplayRecorder* recorder) { this->recorder = recorder; }
+
+    const Board& getBoard() const { return board; }
+    // Changes whenever the locked cells change, so views can cache what they draw.
+    std::uint64_t getBoardRevision() const { return boardRevision; }
+    const Piece& getCurrentPiece() const { return currentPiece; }
+    Piece getNextPiece() const { return Piece(queue.peek(0)); }
+    int getPreviewCount() const { return queue.size(); }
+    int getPreviewType(int i) const { return queue.peek(i); }
+    const Piece& getHoldPiece() const { return holdPiece; }
+    bool hasHoldPiece() const { return holdPiece.type != -1; }
+    bool canHoldPiece() const { return canHold; }
+    Piece getGhostPiece() const;
+
+    std::uint64_t getSeed() const { return seed; }
+    int getScore() const { return score; }
+    int getLevel() const { return level; }
+    int getLinesCleared() const { return linesCleared; }
+    float getFallTime() const { return fallTime; }
+    std::uint32_t getElapsedMs() const { return static_cast<std::uint32_t>(elapsedTime * 1000.0); }
+    bool isGameOver() const { return gameOver; }
+
+private:
+    Piece spawnPiece();
+    bool tryMove(int dx, int dy, int rotations);
+    void hold(StepEvents& events);
+    void hardDrop(StepEvents& events);
+    void lockPiece(StepEvents& events);
+    void checkRows(StepEvents& events, int firstRow, int lastRow);
+
+    EngineConfig config;
+    std::uint64_t seed;
+    PieceQueue queue;
+    Board board;
+    std::uint64_t boardRevision = 0;
+    Piece currentPiece;
+    Piece holdPiece;
+    bool canHold;
+
+    int score;
+    int level;
+    int linesCleared;
+    float fallTime;
+    float currentTime;
+    double elapsedTime;
+    bool gameOver;
+    ReplayRecorder* recorder = nullptr;
+};
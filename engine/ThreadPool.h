@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads, each with its own task deque. A worker runs its
+// newest task first and, once its deque is empty, steals the oldest task from
+// another worker, so uneven work spreads out without every thread contending
+// on one shared queue. A thread waiting in parallelFor() runs and steals tasks
+// too, so nested calls cannot deadlock.
+class ThreadPool {
+public:
+    // 0 starts one worker per hardware thread except the caller's.
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Worker threads, not counting callers of parallelFor().
+    unsigned size() const { return static_cast<unsigned>(threads.size()); }
+
+    // Runs body(0) .. body(count - 1) on the workers and the calling thread and
+    // returns once all of them have finished.
+    void parallelFor(int count, const std::function<void(int)>& body);
+
+private:
+    using Task = std::function<void()>;
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void push(unsigned worker, Task task);
+    // Takes the newest task of worker `own`, else the oldest of any other.
+    bool tryTake(unsigned own, Task& task);
+    void workerLoop(unsigned index);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<unsigned> nextWorker{ 0 };
+
+    // Idle workers sleep here until tasks are queued.
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<int> queued{ 0 };
+    bool stopping = false;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+// Lock-free handoff of the latest value from one producer thread to one consumer
+// thread. The producer fills back() and publishes it; the consumer picks up the
+// newest published value with update() and reads it through front(). Neither
+// side ever waits, and values published between two updates are skipped.
+template <typename T>
+class TripleBuffer {
+public:
+    T& back() {
+        return slots[backIndex];
+    }
+
+    void publish() {
+        backIndex = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Returns whether a newer value was swapped in.
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    const T& front() const {
+        return slots[frontIndex];
+    }
+
+private:
+    static const int INDEX_MASK = 3;
+    static const int FRESH = 4;
+
+    std::array<T, 3> slots;
+    int backIndex = 0;
+    int frontIndex = 1;
+    std::atomic<int> middle{ 2 };
+};
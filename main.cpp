@@ -5,6 +5,7 @@
 #include <vector>
 #include <ctime>
 #include <cstdlib>
+#include <cstdio>
 #include <sstream>
 #include <memory>
 #include <fstream>
@@ -12,158 +13,120 @@
 #include <string>
 #include <SFML/System/Vector2.hpp>
 #include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <filesystem>
+#include <thread>
+#include <atomic>
+#include <future>
+#include "engine/TetrisEngine.h"
+#include "AllocationCounter.h"
+#include "FrameProfiler.h"
+#include "FrameRenderer.h"
+#include "InputThread.h"
+#include "engine/AutoShift.h"
+#include "engine/Bot.h"
+#include "engine/PerfectClear.h"
+#include "engine/TripleBuffer.h"
+#include "engine/ResourcePack.h"
+#include "engine/Leaderboard.h"
+#include "ResourceLoader.h"
 
 using namespace sf;
 
-const int BLOCK_SIZE = 35;
-const int GRID_WIDTH = 10;
-const int GRID_HEIGHT = 25;
-const int SIDEBAR_WIDTH = 400;
-const int SCREEN_WIDTH = GRID_WIDTH * BLOCK_SIZE + SIDEBAR_WIDTH;
-const int SCREEN_HEIGHT = GRID_HEIGHT * BLOCK_SIZE;
-const float INITIAL_FALL_TIME = 0.5f;
-
-enum class GameState {
-    Menu,
-    Playing,
-    Paused,
-    GameOver,
-    HowToPlay,
-    HighScores
+const char* const RESOURCE_PACK_PATH = "resources.pak";
+// The leaderboard lives in leaderboard.log and leaderboard.idx.
+const char* const LEADERBOARD_PATH = "leaderboard";
+// Score files of older versions, newest first; the first one found is imported
+// into an empty leaderboard.
+const std::array<const char*, 3> LEGACY_SCORE_PATHS = { "scores.txt", "highscores.txt", "highscore.txt" };
+const char* const DEFAULT_PLAYER_NAME = "PLAYER";
+// Marathon is the only mode so far; the leaderboard ranks each mode separately.
+const std::uint8_t MARATHON_MODE = 0;
+
+// Each preview piece searched multiplies the bot's work by roughly the number
+// of placements per piece (about 70 with hold).
+const int MAX_BOT_LOOKAHEAD = 2;
+// How long the game over screen of an autoplay game stays up before the bot starts another.
+const float AUTOPLAY_RESTART_DELAY = 3.0f;
+// Positions the perfect-clear hint expands before giving up: a second or two
+// of one core.
+const std::uint64_t HINT_MAX_NODES = 200000;
+
+// Longest wall-clock gap fed to the simulation in one frame, so a stall (window
+// drag, breakpoint) is not followed by a burst of catch-up ticks.
+const float MAX_FRAME_TIME = 0.25f;
+
+// The engine input each gameplay key triggers, indexed by GameKey.
+const std::array<Input, static_cast<int>(GameKey::Count)> KEY_INPUTS = {
+    Input::MoveLeft, Input::MoveRight, Input::SoftDrop, Input::Rotate, Input::HardDrop, Input::Hold
 };
 
-class ParticleSystem {
-private:
-    struct Particle {
-        sf::Vector2f position;
-        sf::Vector2f velocity;
-        sf::Color color;
-        float lifetime;
-    };
-
-    std::vector<Particle> particles;
-    sf::VertexArray vertices;
-    float lifetime;
-
-public:
-    ParticleSystem() : vertices(sf::Points), lifetime(1.0f) {}
-
-    void addParticle(const sf::Vector2f& position, const sf::Color& color) {
-        Particle particle;
-        particle.position = position;
-        particle.velocity = sf::Vector2f(
-            (rand() % 200 - 100) * 0.1f,
-            (rand() % 200 - 100) * 0.1f
-        );
-        particle.color = color;
-        particle.lifetime = lifetime;
-        particles.push_back(particle);
-    }
-
-    void update(float deltaTime) {
-        for (size_t i = 0; i < particles.size();) {
-            Particle& p = particles[i];
-            p.lifetime -= deltaTime;
-
-            if (p.lifetime <= 0) {
-                particles.erase(particles.begin() + i);
-                continue;
-            }
-
-            p.position += p.velocity * deltaTime;
-            p.color.a = static_cast<sf::Uint8>(255 * (p.lifetime / lifetime));
-
-            i++;
-        }
-    }
-
-    void draw(sf::RenderTarget& target) {
-        vertices.clear();
-        for (const auto& particle : particles) {
-            sf::Vertex vertex(particle.position, particle.color);
-            vertices.append(vertex);
-        }
-        target.draw(vertices);
-    }
+struct GameOptions {
+    // When set, every game uses this seed, so runs are reproducible.
+    bool fixedSeed = false;
+    std::uint64_t seed = 0;
+    int previewCount = 4;
+    // When set, the game plays this replay instead of taking input, replaySpeed times faster.
+    std::string replayPath;
+    int replaySpeed = 1;
+    // Write profile_frames.csv and profile_trace.json on exit.
+    bool profile = false;
+    // The game simulates at a fixed tickRate; rendering follows vsync, frameLimit
+    // (when non-zero), or runs uncapped when both are off.
+    int tickRate = 240;
+    int frameLimit = 0;
+    bool vsync = true;
+    // Sample the keyboard on a separate thread; otherwise window key events are used.
+    bool inputThread = true;
+    AutoShiftConfig autoShift;
+    // Recorded with every finished game on the leaderboard.
+    std::string playerName = DEFAULT_PLAYER_NAME;
+    // Start with the bot playing, e.g. on an attract-mode kiosk. The bot places
+    // botPiecesPerSecond pieces a second (as many as it can when 0), looking
+    // botLookahead preview pieces ahead and scoring boards with botWeights.
+    bool autoplay = false;
+    int botPiecesPerSecond = 4;
+    int botLookahead = 1;
+    BotWeights botWeights;
+    // Start with the perfect-clear hint shown (H toggles it). It looks for
+    // perfect clears of at most hintMaxPieces known pieces.
+    bool hint = false;
+    int hintMaxPieces = 7;
 };
 
-const std::array<std::vector<std::vector<std::vector<int>>>, 7> SHAPES = { {
-    {{{1, 1, 1, 1}}, {{1}, {1}, {1}, {1}}},
-    {{{1, 0, 0}, {1, 1, 1}}, {{1, 1}, {1, 0}, {1, 0}}, {{1, 1, 1}, {0, 0, 1}}, {{0, 1}, {0, 1}, {1, 1}}},
-    {{{0, 0, 1}, {1, 1, 1}}, {{1, 0}, {1, 0}, {1, 1}}, {{1, 1, 1}, {1, 0, 0}}, {{1, 1}, {0, 1}, {0, 1}}},
-    {{{1, 1}, {1, 1}}},
-    {{{0, 1, 1}, {1, 1, 0}}, {{1, 0}, {1, 1}, {0, 1}}},
-    {{{0, 1, 0}, {1, 1, 1}}, {{1, 0}, {1, 1}, {1, 0}}, {{1, 1, 1}, {0, 1, 0}}, {{0, 1}, {1, 1}, {0, 1}}},
-    {{{1, 1, 0}, {0, 1, 1}}, {{0, 1}, {1, 1}, {1, 0}}}
-} };
-
-const std::array<sf::Color, 7> COLORS = {
-    sf::Color(0, 255, 255),
-    sf::Color(0, 0, 255),
-    sf::Color(255, 165, 0),
-    sf::Color(255, 255, 0),
-    sf::Color(0, 255, 0),
-    sf::Color(255, 0, 255),
-    sf::Color(255, 0, 0)
+// A perfect-clear search of one position, with the keys that place the
+// solution's first piece.
+struct PerfectClearHint {
+    PerfectClearResult result;
+    std::vector<FinesseKey> finesse;
 };
 
-const sf::Color BACKGROUND_COLOR(30, 30, 30);
-
-struct Piece {
-    int x, y;
-    int rotation;
-    int type;
-    sf::Color color;
-
-    Piece() : x(4), y(0), rotation(0), type(rand() % 7) {
-        color = COLORS[type];
-    }
-
-    std::vector<sf::Vector2i> getBlocks() const {
-        std::vector<sf::Vector2i> blocks;
-        const auto& shape = SHAPES[type][rotation % SHAPES[type].size()];
-
-        for (size_t i = 0; i < shape.size(); ++i) {
-            for (size_t j = 0; j < shape[i].size(); ++j) {
-                if (shape[i][j]) {
-                    blocks.emplace_back(x + j, y + i);
-                }
-            }
-        }
-        return blocks;
-    }
+// One particle of a lock or line-clear burst, sent from the simulation thread
+// to the render thread, which owns the particle system.
+struct ParticleSpawn {
+    sf::Vector2f position;
+    int color;
 };
 
-bool isValidPosition(const Piece& piece, const std::array<std::array<int, GRID_WIDTH>, GRID_HEIGHT>& grid) {
-    for (const auto& block : piece.getBlocks()) {
-        if (block.x < 0 || block.x >= GRID_WIDTH || block.y >= GRID_HEIGHT) return false;
-        if (block.y >= 0 && grid[block.y][block.x]) return false;
-    }
-    return true;
-}
-
 class Game {
 private:
-    void drawGridBackground() {
-        for (int y = 0; y < GRID_HEIGHT; ++y) {
-            for (int x = 0; x < GRID_WIDTH; ++x) {
-                sf::RectangleShape cell(sf::Vector2f(BLOCK_SIZE - 2, BLOCK_SIZE - 2));
-                cell.setPosition(static_cast<float>(x * BLOCK_SIZE + 1),
-                    static_cast<float>(y * BLOCK_SIZE + 1));
-                cell.setFillColor(BACKGROUND_COLOR);
-                cell.setOutlineThickness(1);
-                cell.setOutlineColor(sf::Color(70, 70, 70));
-                window.draw(cell);
-
-                if (grid[y][x]) {
-                    sf::RectangleShape block(sf::Vector2f(BLOCK_SIZE - 2, BLOCK_SIZE - 2));
-                    block.setPosition(static_cast<float>(x * BLOCK_SIZE + 1),
-                        static_cast<float>(y * BLOCK_SIZE + 1));
-                    block.setTexture(&blockTextures[colorsGrid[y][x] - 1]);
-                    window.draw(block);
-                }
-            }
+    // Pixels between where the piece is and where it is drawn: a one-cell step made
+    // by the last tick is blended in over the following tick, so gravity moves look
+    // the same at any render rate.
+    sf::Vector2f fallingPieceOffset() const {
+        const Piece& piece = engine.getCurrentPiece();
+        if (piece.type != pieceBeforeTick.type || piece.rotation != pieceBeforeTick.rotation) {
+            return sf::Vector2f(0.0f, 0.0f);
+        }
+        int dx = piece.x - pieceBeforeTick.x;
+        int dy = piece.y - pieceBeforeTick.y;
+        if (std::abs(dx) + std::abs(dy) != 1) {
+            return sf::Vector2f(0.0f, 0.0f);
         }
+        float remaining = (1.0f - simulationLag / tickLength) * BLOCK_SIZE;
+        return sf::Vector2f(-dx * remaining, -dy * remaining);
     }
 
     void handleGameOverEvents(const sf::Event& event) {
@@ -182,16 +145,16 @@ private:
         }
     }
 
-    sf::Text gameOverText;
-
     void handlePausedEvents(const sf::Event& event) {
         if (event.type == sf::Event::KeyPressed) {
             switch (event.key.code) {
             case sf::Keyboard::Escape:
                 state = GameState::Playing;
                 backgroundMusic.play();
+                resetInput();
                 break;
             case sf::Keyboard::Q:
+                abandonGame();
                 state = GameState::Menu;
                 break;
             default:
@@ -201,20 +164,61 @@ private:
     }
 
     sf::RenderWindow window;
-    std::array<std::array<int, GRID_WIDTH>, GRID_HEIGHT> grid;
-    std::array<std::array<int, GRID_WIDTH>, GRID_HEIGHT> colorsGrid;
-    Piece currentPiece;
-    Piece nextPiece;
-    Piece holdPiece;
-    bool canHold;
-
+    TetrisEngine engine;
+    GameOptions options;
+    std::random_device seedSource;
+
+    // Every game the player plays is recorded and written to replays/ when it
+    // ends or is left: topped out, quit to the menu, restarted or closed.
+    ReplayRecorder recorder;
+    // A game is being recorded and its replay has not been written yet.
+    bool recording = false;
+    Replay replay;
+    ReplayPlayer replayPlayer;
+    bool replaying;
+
+    // In autoplay the bot's inputs for each piece are applied one at a time,
+    // spread evenly over the piece's share of botPiecesPerSecond. The pool and
+    // bot are created the first time autoplay starts.
+    bool autoplay = false;
+    std::unique_ptr<ThreadPool> botPool;
+    std::unique_ptr<Bot> bot;
+    BotMove botMove;
+    std::size_t botStep = 0;
+    float botTimer = 0.0f;
+    float botInputInterval = 0.0f;
+    float autoplayRestartTimer = 0.0f;
+
+    // H toggles the perfect-clear hint. Each time a piece locks or is held,
+    // piecePosition moves on and the solver searches the new position on a
+    // background task, with its own pool so the bot never waits behind it. A
+    // result is shown only if the position is still the same; a search for a
+    // position already gone is cancelled through the flag it was started with.
+    bool showHint = false;
+    std::unique_ptr<ThreadPool> hintPool;
+    std::unique_ptr<PerfectClearSolver> hintSolver;
+    std::shared_ptr<std::atomic<bool>> hintCancel;
+    std::future<PerfectClearHint> hintTask;
+    std::uint64_t piecePosition = 0;
+    std::uint64_t hintTaskPosition = 0;
+    // The position hint belongs to; it differs from piecePosition while searching.
+    std::uint64_t hintPosition = ~0ull;
+    PerfectClearHint hint;
+    // Bumped whenever what the hint shows may have changed.
+    std::uint64_t hintRevision = 0;
+    int replaySpeed;
+    float replayTime;
+
+    // Assets come from resources.pak when it exists, else from the loose files in
+    // resources/. Fonts and music read from that memory for as long as they live.
+    ResourcePack resourcePack;
+    AssetBytes mainFontBytes;
+    AssetBytes titleFontBytes;
+    AssetBytes musicBytes;
     sf::Font mainFont;
     sf::Font titleFont;
     sf::Texture backgroundTexture;
     sf::Texture logoTexture;
-    sf::Texture blockTextures[7];
-    sf::Sprite backgroundSprite;
-    sf::Sprite logoSprite;
 
     sf::SoundBuffer rotateBuffer;
     sf::SoundBuffer clearBuffer;
@@ -225,189 +229,148 @@ private:
     sf::Music backgroundMusic;
 
     GameState state;
-    int score;
-    int level;
-    int linesCleared;
-    int highScore;
+    // Every finished game, ranked; loaded once at startup, new records are
+    // written to disk in the background.
+    Leaderboard leaderboard;
+    LeaderboardPage leaderboardPage;
+    std::vector<std::uint32_t> leaderboardIds;
+    int lastRank = 0;
     sf::Clock clock;
-    float fallTime;
-    float currentTime;
-    bool isGameOver;
 
-    ParticleSystem particles;
-    std::vector<sf::RectangleShape> ghostPiece;
+    // Fixed-step simulation: wall time accumulates in simulationLag and is spent in
+    // tickLength steps. The falling piece is drawn between its state before the
+    // last tick (pieceBeforeTick) and now, in proportion to the leftover lag.
+    float tickLength;
+    float simulationLag;
+    Piece pieceBeforeTick;
+
+    // Key edges from before the game (re)entered Playing, such as the Space that
+    // restarted it, are dropped rather than applied to the new piece.
+    InputThread inputThread;
+    AutoShift autoShift;
+    double playingSince;
+
+    // The simulation runs on the thread that owns the window and its events; a
+    // render thread draws the latest published FrameSnapshot with renderer,
+    // which owns everything drawn, including the particles.
+    std::thread renderThread;
+    std::atomic<bool> quitRequested{ false };
+    std::string renderError;
+    TripleBuffer<FrameSnapshot> snapshots;
+    SpscQueue<ParticleSpawn> particleSpawns{ 4096 };
+
+    Piece ghostPiece;
     float flashEffect;
-
-    sf::RectangleShape sidebar;
-    std::vector<sf::Text> menuOptions;
     int selectedOption;
 
-    void renderHowToPlay() {
-        sf::RectangleShape overlay(sf::Vector2f(SCREEN_WIDTH, SCREEN_HEIGHT));
-        overlay.setFillColor(sf::Color(0, 0, 0, 230));
-        window.draw(overlay);
-
-        sf::Text title("HOW TO PLAY", titleFont, 50);
-        centerText(title, SCREEN_HEIGHT * 0.15f);
-        title.setFillColor(sf::Color::Yellow);
-        window.draw(title);
-
-        std::vector<std::string> instructions = {
-            "CONTROLS:",
-            "Arrow keys Left/Right      Move piece left/right",
-            "Arrow key Up      Rotate piece",
-            "Arrow key Down      Soft drop",
-            "C :     Hold piece",
-            "ESC :     Pause game",
-            "",
-            "SCORING:",
-            "1 line: 100      level",
-            "2 lines: 300     level",
-            "3 lines: 500     level",
-            "4 lines: 800     level"
-        };
-
-        float startY = SCREEN_HEIGHT * 0.3f;
-        for (const auto& line : instructions) {
-            sf::Text text(line, mainFont, 25);
-            centerText(text, startY);
-            window.draw(text);
-            startY += 35;
-        }
-
-        sf::Text backText("Press ESC to return", mainFont, 20);
-        centerText(backText, SCREEN_HEIGHT * 0.9f);
-        window.draw(backText);
-    }
-
-    void renderHighScores() {
-        sf::RectangleShape overlay(sf::Vector2f(SCREEN_WIDTH, SCREEN_HEIGHT));
-        overlay.setFillColor(sf::Color(0, 0, 0, 230));
-        window.draw(overlay);
-
-        sf::Text title("HIGH SCORES", titleFont, 50);
-        centerText(title, SCREEN_HEIGHT * 0.15f);
-        title.setFillColor(sf::Color::Yellow);
-        window.draw(title);
-
-        std::vector<int> topScores = loadTopScores();
-        float startY = SCREEN_HEIGHT * 0.3f;
-
-        for (size_t i = 0; i < topScores.size(); ++i) {
-            std::stringstream ss;
-            ss << (i + 1) << ". " << topScores[i];
-            sf::Text scoreText(ss.str(), mainFont, 30);
-            centerText(scoreText, startY);
-            window.draw(scoreText);
-            startY += 50;
-        }
-
-        sf::Text backText("Press ESC to return", mainFont, 20);
-        centerText(backText, SCREEN_HEIGHT * 0.9f);
-        window.draw(backText);
-    }
-
-    std::vector<int> loadTopScores() {
-        std::vector<int> scores;
-        std::ifstream file("highscores.txt");
-        int score;
-        while (file >> score && scores.size() < 5) {
-            scores.push_back(score);
-        }
-        file.close();
-
-        while (scores.size() < 5) {
-            scores.push_back(0);
-        }
-        return scores;
-    }
-
-    void saveTopScores(int newScore) {
-        std::vector<int> scores = loadTopScores();
-        scores.push_back(newScore);
-        std::sort(scores.begin(), scores.end(), std::greater<int>());
-        scores.resize(5);
-
-        std::ofstream file("highscores.txt");
-        for (int score : scores) {
-            file << score << "\n";
-        }
-        file.close();
-    }
-void setupSpritesAndUI() {
-    backgroundSprite.setTexture(backgroundTexture);
-    logoSprite.setTexture(logoTexture);
-
-    float logoScale = 0.7f;
-    logoSprite.setScale(logoScale, logoScale);
-
-    sidebar.setSize(sf::Vector2f(SIDEBAR_WIDTH, SCREEN_HEIGHT));
-    sidebar.setPosition(GRID_WIDTH * BLOCK_SIZE, 0);
-    sidebar.setFillColor(sf::Color(30, 30, 30, 230));
-
-    menuOptions = {
-        createText("Start Game", 40),
-        createText("How to Play", 40),
-        createText("High Scores", 40),
-        createText("Exit", 40)
-    };
-
-    float menuY = SCREEN_HEIGHT / 2;
-    for (size_t i = 0; i < menuOptions.size(); ++i) {
-        centerText(menuOptions[i], menuY + i * 60);
-    }
-}
-
+    // F3 toggles the profiler overlay.
+    FrameProfiler profiler;
+    bool showProfiler = false;
+    // Loaded with the assets, then used only by the render thread.
+    FrameRenderer renderer{ profiler };
 
 public:
-   Game() : window(sf::VideoMode(SCREEN_WIDTH, SCREEN_HEIGHT), "TETRIS",
+   explicit Game(const GameOptions& options) : window(sf::VideoMode(SCREEN_WIDTH, SCREEN_HEIGHT), "TETRIS",
     sf::Style::Titlebar | sf::Style::Close),
-    score(0), level(1), linesCleared(0), fallTime(INITIAL_FALL_TIME),
-    currentTime(0.0f), isGameOver(false), canHold(true), state(GameState::Menu),
+    engine(makeEngineConfig(options)), options(options),
+    replayPlayer(replay), replaying(!options.replayPath.empty()), replaySpeed(options.replaySpeed), replayTime(0.0f),
+    state(GameState::Menu), leaderboard(LEADERBOARD_PATH), tickLength(1.0f / options.tickRate), simulationLag(0.0f),
+    autoShift(options.autoShift), playingSince(0.0),
     selectedOption(0),
     flashEffect(0.0f) {
 
-    window.setFramerateLimit(60);
+    if (options.frameLimit > 0) {
+        window.setFramerateLimit(options.frameLimit);
+    }
+    else {
+        window.setVerticalSyncEnabled(options.vsync);
+    }
+    profiler.setHitchLog(&std::cerr);
+    // Held keys repeat through AutoShift, not the OS key repeat.
+    window.setKeyRepeatEnabled(false);
+    if (replaying && !replay.load(options.replayPath)) {
+        throw std::runtime_error("Failed to load replay " + options.replayPath);
+    }
     initializeResources();
     initializeGame();
-    loadHighScore();
+    loadScores();
+    if (options.inputThread) {
+        inputThread.start();
+    }
+    if (replaying) {
+        setReplaySpeed(replaySpeed);
+        state = GameState::Playing;
+    }
+    else if (options.autoplay) {
+        startGame(true);
+    }
+    if (options.hint) {
+        toggleHint();
+    }
 }
 private:
+    // Files are read and decoded on worker threads while a progress bar is drawn;
+    // fonts, textures and sound buffers are then created here, on the thread that
+    // owns the GL context.
     void initializeResources() {
-    try {
-        if (!mainFont.loadFromFile("resources/main_font.ttf")) {
-            throw std::runtime_error("Failed to load main_font.ttf");
-        }
-        if (!titleFont.loadFromFile("resources/title_font.ttf")) {
-            throw std::runtime_error("Failed to load title_font.ttf");
-        }
-
-        if (!backgroundTexture.loadFromFile("resources/background.png")) {
-            throw std::runtime_error("Failed to load background.png");
-        }
-        if (!logoTexture.loadFromFile("resources/university_logo.png")) {
-            throw std::runtime_error("Failed to load university_logo.png");
+        if (std::filesystem::exists(RESOURCE_PACK_PATH) && !resourcePack.open(RESOURCE_PACK_PATH)) {
+            throw std::runtime_error(resourcePack.getError());
         }
 
-        for (int i = 0; i < 7; i++) {
-            std::string filename = "resources/block" + std::to_string(i) + ".png";
-            if (!blockTextures[i].loadFromFile(filename)) {
-                throw std::runtime_error("Failed to load " + filename);
-            }
-        }
+        sf::Image backgroundImage;
+        sf::Image logoImage;
+        std::array<sf::Image, BoardRenderer::BLOCK_TYPES> blockImages;
+        std::array<DecodedSound, 3> decodedSounds;
+        std::array<sf::SoundBuffer*, 3> soundBuffers = { &rotateBuffer, &clearBuffer, &dropBuffer };
+        const char* soundNames[] = { "rotate.wav", "clear.wav", "drop.wav" };
+        // Declared after everything its steps write into: if poll() throws, the
+        // loader's destructor waits for the running decodes before those go away.
+        ResourceLoader loader;
+
+        auto loadImage = [this](sf::Image& image) {
+            return [this, &image](const std::string& name) {
+                AssetBytes bytes;
+                return readAsset(name, bytes) && image.loadFromMemory(bytes.data, bytes.size);
+            };
+        };
 
-        if (!rotateBuffer.loadFromFile("resources/rotate.wav")) {
-            throw std::runtime_error("Failed to load rotate.wav");
-        }
-        if (!clearBuffer.loadFromFile("resources/clear.wav")) {
-            throw std::runtime_error("Failed to load clear.wav");
+        loader.add("main_font.ttf",
+            [this](const std::string& name) { return readAsset(name, mainFontBytes); },
+            [this](const std::string&) { return mainFont.loadFromMemory(mainFontBytes.data, mainFontBytes.size); });
+        loader.add("title_font.ttf",
+            [this](const std::string& name) { return readAsset(name, titleFontBytes); },
+            [this](const std::string&) { return titleFont.loadFromMemory(titleFontBytes.data, titleFontBytes.size); });
+        loader.add("background.png", loadImage(backgroundImage),
+            [&](const std::string&) { return backgroundTexture.loadFromImage(backgroundImage); });
+        loader.add("university_logo.png", loadImage(logoImage),
+            [&](const std::string&) { return logoTexture.loadFromImage(logoImage); });
+        for (int i = 0; i < BoardRenderer::BLOCK_TYPES; i++) {
+            loader.add("block" + std::to_string(i) + ".png", loadImage(blockImages[i]));
         }
-        if (!dropBuffer.loadFromFile("resources/drop.wav")) {
-            throw std::runtime_error("Failed to load drop.wav");
+        for (size_t i = 0; i < decodedSounds.size(); ++i) {
+            loader.add(soundNames[i],
+                [this, &decodedSounds, i](const std::string& name) {
+                    AssetBytes bytes;
+                    return readAsset(name, bytes) && decodedSounds[i].decode(bytes);
+                },
+                [&decodedSounds, &soundBuffers, i](const std::string&) { return decodedSounds[i].loadInto(*soundBuffers[i]); });
         }
-        if (!backgroundMusic.openFromFile("resources/background_music.ogg")) {
-            throw std::runtime_error("Failed to load background_music.ogg");
+        // The music streams from the pack mapping (or the file's bytes) while it plays.
+        loader.add("background_music.ogg", [this](const std::string& name) {
+            return readAsset(name, musicBytes) && backgroundMusic.openFromMemory(musicBytes.data, musicBytes.size);
+        });
+
+        loader.start();
+        while (!loader.poll()) {
+            sf::Event event;
+            while (window.pollEvent(event)) {
+                if (event.type == sf::Event::Closed)
+                    quitRequested = true;
+            }
+            drawLoadingScreen(static_cast<float>(loader.getLoadedCount()) / loader.getAssetCount());
+            sf::sleep(sf::milliseconds(5));
         }
+        loader.report(std::cerr);
 
         rotateSound.setBuffer(rotateBuffer);
         clearSound.setBuffer(clearBuffer);
@@ -415,90 +378,189 @@ private:
         backgroundMusic.setLoop(true);
         backgroundMusic.setVolume(40);
 
-        setupSpritesAndUI();
+        renderer.load(mainFont, titleFont, backgroundTexture, logoTexture, blockImages);
     }
-    catch (const std::runtime_error& e) {
-        throw;
+
+    // Called from loader threads. Pack entries are checked against their CRC-32
+    // before use.
+    bool readAsset(const std::string& name, AssetBytes& bytes) {
+        if (!resourcePack.isOpen()) {
+            return ResourceLoader::readFile("resources/" + name, bytes);
+        }
+        const PackEntry* entry = resourcePack.find(name);
+        if (!entry || !resourcePack.verify(*entry)) {
+            return false;
+        }
+        bytes.data = resourcePack.data(*entry);
+        bytes.size = static_cast<std::size_t>(entry->size);
+        return true;
     }
-}
-    sf::Text createText(const std::string& content, unsigned int size) {
-        sf::Text text;
-        text.setFont(mainFont);
-        text.setString(content);
-        text.setCharacterSize(size);
-        text.setFillColor(sf::Color::White);
-        return text;
+
+    // Nothing is loaded yet, so the loading screen is only a progress bar.
+    void drawLoadingScreen(float progress) {
+        const sf::Vector2f barSize(SCREEN_WIDTH * 0.6f, 24.0f);
+        const sf::Vector2f barPosition((SCREEN_WIDTH - barSize.x) / 2, (SCREEN_HEIGHT - barSize.y) / 2);
+
+        sf::RectangleShape outline(barSize);
+        outline.setPosition(barPosition);
+        outline.setFillColor(sf::Color::Transparent);
+        outline.setOutlineColor(sf::Color(200, 200, 200));
+        outline.setOutlineThickness(2.0f);
+
+        sf::RectangleShape fill(sf::Vector2f(barSize.x * progress, barSize.y));
+        fill.setPosition(barPosition);
+        fill.setFillColor(sf::Color::Yellow);
+
+        window.clear(BACKGROUND_COLOR);
+        window.draw(outline);
+        window.draw(fill);
+        window.display();
     }
 
-    void centerText(sf::Text& text, float y) {
-        sf::FloatRect bounds = text.getLocalBounds();
-        text.setOrigin(bounds.width / 2, bounds.height / 2);
-        text.setPosition(SCREEN_WIDTH / 2, y);
+    static EngineConfig makeEngineConfig(const GameOptions& options) {
+        EngineConfig config;
+        config.seed = options.seed;
+        config.previewCount = options.previewCount;
+        return config;
     }
+
+    std::uint64_t nextGameSeed() {
+        if (options.fixedSeed) return options.seed;
+        return (static_cast<std::uint64_t>(seedSource()) << 32) | seedSource();
+    }
+
     void initializeGame() {
-    grid.fill({});
-    colorsGrid.fill({});
-    score = 0;
-    level = 1;
-    linesCleared = 0;
-    fallTime = INITIAL_FALL_TIME;
-    currentTime = 0.0f;
-    isGameOver = false;
-    canHold = true;
-    currentPiece = Piece();
-    nextPiece = Piece();
-    holdPiece = Piece();
-    holdPiece.type = -1;
+    abandonGame();
+    if (replaying) {
+        replayPlayer.start(engine);
+        replayTime = 0.0f;
+    }
+    else {
+        engine.reset(nextGameSeed());
+        // Bot games are neither recorded nor ranked.
+        if (autoplay) {
+            engine.setRecorder(nullptr);
+        }
+        else {
+            recorder.begin(engine.getSeed(), engine.getPreviewCount());
+            engine.setRecorder(&recorder);
+            recording = true;
+        }
+    }
+    botMove.inputs.clear();
+    botStep = 0;
+    piecePosition++;
+    hintRevision++;
     updateGhostPiece();
     flashEffect = 0.0f;
+    simulationLag = 0.0f;
+    pieceBeforeTick = engine.getCurrentPiece();
+    resetInput();
 }
 
-    void updateGhostPiece() {
-        ghostPiece.clear();
-        Piece ghost = currentPiece;
-        while (isValidPosition(ghost, grid)) {
-            ghost.y++;
-        }
-        ghost.y--;
-
-        for (const auto& block : ghost.getBlocks()) {
-            if (block.y >= 0) {
-                sf::RectangleShape rect(sf::Vector2f(BLOCK_SIZE - 2, BLOCK_SIZE - 2));
-                rect.setPosition(block.x * BLOCK_SIZE + 1, block.y * BLOCK_SIZE + 1);
-                rect.setFillColor(sf::Color(currentPiece.color.r, currentPiece.color.g,
-                    currentPiece.color.b, 50));
-                ghostPiece.push_back(rect);
-            }
+    void resetInput() {
+        autoShift.reset();
+        playingSince = InputThread::now();
+    }
+
+    // Returns the replay's path, or an empty string if it could not be written.
+    std::string saveReplay() {
+        std::error_code error;
+        std::filesystem::create_directories("replays", error);
+        std::string path = "replays/" + std::to_string(std::time(nullptr)) + "-" + std::to_string(engine.getSeed()) + ".trp";
+        bool saved = recorder.save(path, engine.getScore(), engine.getLinesCleared(), engine.getLevel(), engine.getElapsedMs());
+        engine.setRecorder(nullptr);
+        recording = false;
+        return saved ? path : std::string();
+    }
+
+    // Saves the replay of a game left before it ended, up to where it was left;
+    // the footer holds the score at that point. Such games are not ranked. The
+    // game set up behind the menu at startup has no events and is not saved.
+    void abandonGame() {
+        if (recording && recorder.eventCount() > 0) {
+            saveReplay();
         }
     }
 
-    void loadHighScore() {
-        std::ifstream file("highscore.txt");
-        if (file.is_open()) {
-            file >> highScore;
-            file.close();
+    void setReplaySpeed(int speed) {
+        replaySpeed = speed;
+    }
+
+    void updateGhostPiece() {
+        ghostPiece = engine.getGhostPiece();
+    }
+
+    // A leaderboard that cannot be opened still ranks this session's games; they
+    // are just not saved.
+    void loadScores() {
+        if (!leaderboard.open()) {
+            std::cerr << "Scores will not be saved: " << leaderboard.getError() << "\n";
         }
-        else {
-            highScore = 0;
+        if (leaderboard.recordCount() == 0) {
+            importLegacyScores();
         }
+        refreshLeaderboardPage();
     }
 
-    void saveHighScore() {
-        if (score > highScore) {
-            highScore = score;
-            std::ofstream file("highscore.txt");
-            if (file.is_open()) {
-                file << highScore;
-                file.close();
+    // Older versions kept bare scores, one per line; they are carried over under
+    // the default player name.
+    void importLegacyScores() {
+        for (const char* path : LEGACY_SCORE_PATHS) {
+            std::ifstream file(path);
+            if (!file.is_open()) continue;
+            LeaderboardRecord record;
+            record.player = DEFAULT_PLAYER_NAME;
+            record.mode = MARATHON_MODE;
+            while (file >> record.score) {
+                if (record.score > 0) {
+                    leaderboard.add(record);
+                }
             }
+            return;
         }
     }
 
+    // Fills leaderboardPage with the rows of its page, clamped to the pages there are.
+    void refreshLeaderboardPage() {
+        const int pageSize = LeaderboardPage::PAGE_SIZE;
+        LeaderboardPage& page = leaderboardPage;
+        page.pageCount = static_cast<int>((leaderboard.size(MARATHON_MODE) + pageSize - 1) / pageSize);
+        page.page = std::max(0, std::min(page.page, page.pageCount - 1));
+        leaderboard.top(MARATHON_MODE, static_cast<size_t>(page.page) * pageSize, pageSize, leaderboardIds);
+        page.rowCount = static_cast<int>(leaderboardIds.size());
+        for (int i = 0; i < page.rowCount; ++i) {
+            const Leaderboard::Summary& summary = leaderboard.getSummary(leaderboardIds[i]);
+            const std::string& name = leaderboard.getPlayerName(summary.player);
+            LeaderboardPage::Row& row = page.rows[i];
+            row.rank = page.page * pageSize + i + 1;
+            size_t length = std::min(name.size(), row.player.size() - 1);
+            std::copy_n(name.begin(), length, row.player.begin());
+            row.player[length] = '\0';
+            row.score = summary.score;
+            row.level = summary.level;
+            row.lines = summary.lines;
+        }
+        page.revision++;
+    }
+
+    void showLeaderboardPage(int index) {
+        leaderboardPage.page = index;
+        refreshLeaderboardPage();
+    }
+
     void handleEvents() {
         sf::Event event;
         while (window.pollEvent(event)) {
             if (event.type == sf::Event::Closed)
-                window.close();
+                quitRequested = true;
+            if (event.type == sf::Event::GainedFocus || event.type == sf::Event::LostFocus) {
+                inputThread.setFocused(event.type == sf::Event::GainedFocus);
+                autoShift.reset();
+            }
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F3) {
+                showProfiler = !showProfiler;
+            }
 
             switch (state) {
             case GameState::Menu:
@@ -514,24 +576,47 @@ private:
                 handleGameOverEvents(event);
                 break;
             case GameState::HowToPlay:
-            case GameState::HighScores:
                 if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape) {
                     state = GameState::Menu;
                 }
                 break;
+            case GameState::HighScores:
+                handleHighScoresEvents(event);
+                break;
             }
         }
     }
 
 
+    void handleHighScoresEvents(const sf::Event& event) {
+        if (event.type != sf::Event::KeyPressed) return;
+        switch (event.key.code) {
+        case sf::Keyboard::Escape:
+            state = GameState::Menu;
+            break;
+        case sf::Keyboard::Left:
+            if (leaderboardPage.page > 0) {
+                showLeaderboardPage(leaderboardPage.page - 1);
+            }
+            break;
+        case sf::Keyboard::Right:
+            if (leaderboardPage.page + 1 < leaderboardPage.pageCount) {
+                showLeaderboardPage(leaderboardPage.page + 1);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
     void handleMenuEvents(const sf::Event& event) {
         if (event.type == sf::Event::KeyPressed) {
             switch (event.key.code) {
             case sf::Keyboard::Up:
-                selectedOption = (selectedOption - 1 + menuOptions.size()) % menuOptions.size();
+                selectedOption = (selectedOption - 1 + MENU_LABELS.size()) % MENU_LABELS.size();
                 break;
             case sf::Keyboard::Down:
-                selectedOption = (selectedOption + 1) % menuOptions.size();
+                selectedOption = (selectedOption + 1) % MENU_LABELS.size();
                 break;
             case sf::Keyboard::Return:
                 executeMenuOption();
@@ -545,46 +630,119 @@ private:
     void executeMenuOption() {
         switch (selectedOption) {
         case 0:
-            initializeGame();
-            state = GameState::Playing;
-            backgroundMusic.play();
+            endReplaySession();
+            startGame(false);
             break;
         case 1:
-            state = GameState::HowToPlay;
+            endReplaySession();
+            startGame(true);
             break;
         case 2:
-            state = GameState::HighScores;
+            state = GameState::HowToPlay;
             break;
         case 3:
-            window.close();
+            showLeaderboardPage(0);
+            state = GameState::HighScores;
+            break;
+        case 4:
+            quitRequested = true;
             break;
         }
     }
 
+    // A game started from the menu after watching a --replay is a new game with
+    // this session's options, recorded and ranked as usual, not the replay again.
+    void endReplaySession() {
+        if (replaying) {
+            replaying = false;
+            engine.reset(makeEngineConfig(options));
+        }
+    }
+
+    void startGame(bool withBot) {
+        autoplay = withBot;
+        if (autoplay && !bot) {
+            botPool = std::make_unique<ThreadPool>();
+            BotConfig config;
+            config.weights = options.botWeights;
+            config.lookahead = options.botLookahead;
+            bot = std::make_unique<Bot>(config, botPool.get());
+        }
+        initializeGame();
+        state = GameState::Playing;
+        backgroundMusic.play();
+    }
+
     void handleGameEvents(const sf::Event& event) {
+        if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::H) {
+            toggleHint();
+            return;
+        }
+        if (replaying) {
+            handleReplayEvents(event);
+            return;
+        }
+        if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape) {
+            state = GameState::Paused;
+            backgroundMusic.pause();
+            return;
+        }
+        if (autoplay) return;
+
+        // Without the input thread, window key events feed the same path.
+        bool isKeyEvent = event.type == sf::Event::KeyPressed || event.type == sf::Event::KeyReleased;
+        if (!inputThread.isRunning() && isKeyEvent) {
+            for (size_t i = 0; i < GAME_KEY_BINDINGS.size(); ++i) {
+                if (GAME_KEY_BINDINGS[i] == event.key.code) {
+                    onKeyEvent(KeyEvent{ static_cast<GameKey>(i), event.type == sf::Event::KeyPressed, InputThread::now() });
+                }
+            }
+        }
+    }
+
+    // Applies queued key edges from the input thread, then any auto-repeats due now.
+    void processInput() {
+        KeyEvent event;
+        while (inputThread.poll(event)) {
+            if (state == GameState::Playing && !replaying && !autoplay && event.time >= playingSince) {
+                onKeyEvent(event);
+            }
+        }
+
+        if (state == GameState::Playing && !replaying && !autoplay) {
+            autoShift.update(InputThread::now(), [this](Input input) {
+                StepEvents events = engine.applyInput(input);
+                handleStepEvents(events);
+                pieceBeforeTick = engine.getCurrentPiece();
+                return events.moved;
+            });
+        }
+    }
+
+    void onKeyEvent(const KeyEvent& event) {
+        Input input = KEY_INPUTS[static_cast<int>(event.key)];
+        if (!event.pressed) {
+            autoShift.release(input, event.time);
+            return;
+        }
+        handleStepEvents(engine.applyInput(input));
+        autoShift.press(input, event.time);
+        // Player moves show up immediately rather than being blended in.
+        pieceBeforeTick = engine.getCurrentPiece();
+    }
+
+    // During playback the keys only change speed or pause.
+    void handleReplayEvents(const sf::Event& event) {
         if (event.type == sf::Event::KeyPressed) {
-            Piece temp = currentPiece;
             switch (event.key.code) {
-            case sf::Keyboard::Left:
-                temp.x--;
+            case sf::Keyboard::Num1:
+                setReplaySpeed(1);
                 break;
-            case sf::Keyboard::Right:
-                temp.x++;
+            case sf::Keyboard::Num2:
+                setReplaySpeed(4);
                 break;
-            case sf::Keyboard::Down:
-                temp.y++;
-                break;
-            case sf::Keyboard::Up:
-                temp.rotation = (temp.rotation + 1) % SHAPES[temp.type].size();
-                if (isValidPosition(temp, grid)) {
-                    rotateSound.play();
-                }
-                break;
-            case sf::Keyboard::Space:
-                hardDrop();
-                break;
-            case sf::Keyboard::C:
-                handleHoldPiece();
+            case sf::Keyboard::Num3:
+                setReplaySpeed(16);
                 break;
             case sf::Keyboard::Escape:
                 state = GameState::Paused;
@@ -593,444 +751,453 @@ private:
             default:
                 break;
             }
-            if (isValidPosition(temp, grid)) {
-                currentPiece = temp;
-                updateGhostPiece();
-            }
         }
     }
 
-    void handleHoldPiece() {
-        if (!canHold) return;
-
-        if (holdPiece.type == -1) {
-            holdPiece = currentPiece;
-            currentPiece = nextPiece;
-            nextPiece = Piece();
+    // Front-end side of an engine step: sounds, particles and state changes.
+    void handleStepEvents(const StepEvents& events) {
+        if (events.rotated) {
+            rotateSound.play();
         }
-        else {
-            std::swap(holdPiece, currentPiece);
-            currentPiece.x = 4;
-            currentPiece.y = 0;
-            currentPiece.rotation = 0;
+        if (events.locked || events.held) {
+            piecePosition++;
+            hintRevision++;
         }
 
-        canHold = false;
-        updateGhostPiece();
-    }
-
-    void hardDrop() {
-        while (isValidPosition(currentPiece, grid)) {
-            currentPiece.y++;
+        if (events.locked) {
+            profiler.flag(FrameFlags::Lock);
+            for (const auto& block : events.lockedCells) {
+                if (block.y >= 0) {
+                    particleSpawns.tryPush(ParticleSpawn{
+                        sf::Vector2f(block.x * BLOCK_SIZE + BLOCK_SIZE / 2,
+                            block.y * BLOCK_SIZE + BLOCK_SIZE / 2),
+                        events.lockedType
+                    });
+                }
+            }
         }
-        currentPiece.y--;
-        lockPiece();
-        dropSound.play();
-        currentTime = 0.0f;
-    }
 
-    void lockPiece() {
-    for (const auto& block : currentPiece.getBlocks()) {
-        if (block.y >= 0) {
-            grid[block.y][block.x] = 1;
-            colorsGrid[block.y][block.x] = currentPiece.type + 1;
-            particles.addParticle(
-                sf::Vector2f(block.x * BLOCK_SIZE + BLOCK_SIZE / 2,
-                    block.y * BLOCK_SIZE + BLOCK_SIZE / 2),
-                currentPiece.color
-            );
+        const LineClear& lineClear = events.lineClear;
+        for (int y = GRID_HEIGHT - 1, i = 0; i < lineClear.count; --y) {
+            if (!(lineClear.rowMask & (1u << y))) continue;
+            for (int x = 0; x < GRID_WIDTH; x++) {
+                int color = static_cast<int>((lineClear.colors[i] >> (x * COLOR_BITS)) & COLOR_MASK);
+                particleSpawns.tryPush(ParticleSpawn{
+                    sf::Vector2f(x * BLOCK_SIZE + BLOCK_SIZE / 2, y * BLOCK_SIZE + BLOCK_SIZE / 2),
+                    color - 1
+                });
+            }
+            i++;
         }
-    }
 
-        currentPiece = nextPiece;
-        nextPiece = Piece();
-        canHold = true;
-        if (!isValidPosition(currentPiece, grid)) {
-            gameOver();
+        if (lineClear.count > 0) {
+            profiler.flag(FrameFlags::LineClear);
+            clearSound.play();
+            flashEffect = 0.5f;
         }
 
-        checkRows();
-        updateGhostPiece();
-    }
-
-    void gameOver() {
-        state = GameState::GameOver;
-        saveHighScore();
-        saveTopScores(score);
-        backgroundMusic.stop();
-    }
-
-    void checkRows() {
-        int rowsCleared = 0;
-        for (int y = GRID_HEIGHT - 1; y >= 0; --y) {
-            bool full = true;
-            for (int x = 0; x < GRID_WIDTH; ++x) {
-                if (!grid[y][x]) {
-                    full = false;
-                    break;
-                }
-            }
-
-            if (full) {
-                rowsCleared++;
-                for (int x = 0; x < GRID_WIDTH; x++) {
-                    particles.addParticle(
-                        sf::Vector2f(x * BLOCK_SIZE + BLOCK_SIZE / 2, y * BLOCK_SIZE + BLOCK_SIZE / 2),
-                        COLORS[colorsGrid[y][x] - 1]
-                    );
-                }
+        if (events.hardDropped) {
+            dropSound.play();
+        }
 
-                for (int row = y; row > 0; --row) {
-                    grid[row] = grid[row - 1];
-                    colorsGrid[row] = colorsGrid[row - 1];
-                }
-                grid[0].fill(0);
-                colorsGrid[0].fill(0);
-                ++y;
-            }
+        if (events.pieceChanged()) {
+            updateGhostPiece();
         }
 
-        if (rowsCleared > 0) {
-            clearSound.play();
-            score += calculateScore(rowsCleared);
-            linesCleared += rowsCleared;
-            level = 1 + (linesCleared / 10);
-            fallTime = std::max(0.1f, INITIAL_FALL_TIME - (level - 1) * 0.05f);
-            flashEffect = 0.5f;
+        if (events.gameOver) {
+            gameOver();
         }
     }
 
-    int calculateScore(int rows) {
-        switch (rows) {
-        case 1: return 100 * level;
-        case 2: return 300 * level;
-        case 3: return 500 * level;
-        case 4: return 800 * level;
-        default: return 0;
+    void gameOver() {
+        state = GameState::GameOver;
+        lastRank = 0;
+        autoplayRestartTimer = 0.0f;
+        if (!replaying && !autoplay) {
+            LeaderboardRecord record;
+            record.player = options.playerName;
+            record.mode = MARATHON_MODE;
+            record.score = engine.getScore();
+            record.lines = engine.getLinesCleared();
+            record.level = engine.getLevel();
+            record.durationMs = engine.getElapsedMs();
+            record.timestamp = static_cast<std::int64_t>(std::time(nullptr));
+            record.replayPath = saveReplay();
+            lastRank = static_cast<int>(leaderboard.rankOf(leaderboard.add(record))) + 1;
+            refreshLeaderboardPage();
         }
+        backgroundMusic.stop();
     }
 
     void update() {
-        float deltaTime = clock.restart().asSeconds();
+        float deltaTime = std::min(clock.restart().asSeconds(), MAX_FRAME_TIME);
+        processInput();
 
         switch (state) {
         case GameState::Playing:
-            updateGame(deltaTime);
-            break;
-        case GameState::Menu:
-            updateMenu(deltaTime);
+            if (autoplay) {
+                playBot(deltaTime);
+            }
+            simulationLag += deltaTime;
+            while (simulationLag >= tickLength && state == GameState::Playing) {
+                pieceBeforeTick = engine.getCurrentPiece();
+                updateGame(tickLength);
+                simulationLag -= tickLength;
+            }
             break;
         case GameState::GameOver:
-            updateGameOver(deltaTime);
+            autoplayRestartTimer += deltaTime;
+            if (autoplay && autoplayRestartTimer >= AUTOPLAY_RESTART_DELAY) {
+                startGame(true);
+            }
             break;
         default:
             break;
         }
 
-        particles.update(deltaTime);
+        updateHint();
+
         if (flashEffect > 0) {
             flashEffect -= deltaTime;
         }
     }
 
-    void updateGame(float deltaTime) {
-        currentTime += deltaTime;
-        if (currentTime >= fallTime) {
-            currentTime = 0.0f;
-            Piece temp = currentPiece;
-            temp.y++;
-            if (isValidPosition(temp, grid)) {
-                currentPiece = temp;
-                updateGhostPiece();
-            }
-            else {
-                lockPiece();
-            }
+    void publishSnapshot() {
+        FrameSnapshot& frame = snapshots.back();
+        frame.state = state;
+        frame.board = engine.getBoard();
+        frame.boardRevision = engine.getBoardRevision();
+        frame.currentPiece = engine.getCurrentPiece();
+        frame.ghostPiece = ghostPiece;
+        frame.pieceOffset = fallingPieceOffset();
+        frame.hasHoldPiece = engine.hasHoldPiece();
+        frame.holdPiece = engine.getHoldPiece();
+        frame.previewCount = std::min(engine.getPreviewCount(), MAX_SHOWN_PREVIEWS);
+        for (int i = 0; i < frame.previewCount; ++i) {
+            frame.previewTypes[i] = engine.getPreviewType(i);
+        }
+        frame.score = engine.getScore();
+        frame.level = engine.getLevel();
+        frame.lines = engine.getLinesCleared();
+        frame.highScore = leaderboard.bestScore(MARATHON_MODE);
+        frame.lastRank = lastRank;
+        frame.leaderboardPage = leaderboardPage;
+        frame.selectedOption = selectedOption;
+        frame.replaying = replaying;
+        frame.replaySpeed = replaySpeed;
+        frame.autoplay = autoplay;
+        frame.showProfiler = showProfiler;
+        frame.showHint = showHint;
+        if (showHint && frame.hintRevision != hintRevision) {
+            copyHint(frame);
+            frame.hintRevision = hintRevision;
         }
+        snapshots.publish();
     }
 
-    void updateMenu(float deltaTime) {
-    static float pulseTime = 0;
-    pulseTime += deltaTime * 2;
+    // Render-thread side of a new snapshot: the particles the simulation sent,
+    // then the renderer's animations and text.
+    void updateView(const FrameSnapshot& frame, float deltaTime) {
+        ParticleSpawn spawn;
+        while (particleSpawns.tryPop(spawn)) {
+            renderer.addParticle(spawn.position, spawn.color);
+        }
+        renderer.update(frame, deltaTime);
+    }
 
-    for (size_t i = 0; i < menuOptions.size(); ++i) {
-        if (i == selectedOption) {
-            float pulse = (sin(pulseTime) + 1) / 2;
-            menuOptions[i].setFillColor(sf::Color(255, 255, 0,
-                static_cast<sf::Uint8>(155 + 100 * pulse)));
-            menuOptions[i].setScale(1.1f, 1.1f);
+    void updateGame(float deltaTime) {
+        if (replaying) {
+            updateReplay(deltaTime);
+            return;
         }
-        else {
-            menuOptions[i].setFillColor(sf::Color::White);
-            menuOptions[i].setScale(1.0f, 1.0f);
+        StepEvents events = engine.step(deltaTime);
+        handleStepEvents(events);
+        // Gravity moved the piece off the bot's path; plan again from where it is.
+        if (autoplay && (events.moved || events.locked)) {
+            botStep = botMove.inputs.size();
         }
     }
-}
 
-    void updateGameOver(float deltaTime) {
-        static float textPulse = 0;
-        textPulse += deltaTime * 2;
-        gameOverText.setFillColor(sf::Color(255, 0, 0,
-            static_cast<sf::Uint8>(155 + 100 * ((sin(textPulse) + 1) / 2))));
+    // Applies the bot's inputs as they fall due, planning the next move once
+    // the last one is used up. The search runs on the bot's thread pool.
+    void playBot(float deltaTime) {
+        if (botStep >= botMove.inputs.size()) {
+            if (!bot->chooseMove(engine, botMove)) return;
+            botStep = 0;
+            botTimer = 0.0f;
+            botInputInterval = options.botPiecesPerSecond > 0 ?
+                1.0f / (options.botPiecesPerSecond * botMove.inputs.size()) : 0.0f;
+        }
+        botTimer += deltaTime;
+        while (state == GameState::Playing && botStep < botMove.inputs.size() && botTimer >= botInputInterval) {
+            botTimer -= botInputInterval;
+            handleStepEvents(engine.applyInput(botMove.inputs[botStep++]));
+            pieceBeforeTick = engine.getCurrentPiece();
+        }
     }
 
-    void render() {
-    window.clear(BACKGROUND_COLOR);
-    window.draw(backgroundSprite);
+    void toggleHint() {
+        showHint = !showHint;
+        if (showHint && !hintSolver) {
+            hintPool = std::make_unique<ThreadPool>();
+            PerfectClearConfig config;
+            config.maxPieces = options.hintMaxPieces;
+            config.maxNodes = HINT_MAX_NODES;
+            hintSolver = std::make_unique<PerfectClearSolver>(config, hintPool.get());
+        }
+        hintRevision++;
+    }
 
-    switch (state) {
-        case GameState::Playing:
-            drawGridBackground();
-            for (const auto& block : ghostPiece) {
-                window.draw(block);
+    // Takes in a finished search, then starts one for the current position if
+    // the hint does not show it yet and no search is running.
+    void updateHint() {
+        if (hintTask.valid() && hintTask.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            PerfectClearHint result = hintTask.get();
+            if (hintTaskPosition == piecePosition) {
+                hint = std::move(result);
+                hintPosition = hintTaskPosition;
+                hintRevision++;
             }
-            for (const auto& block : currentPiece.getBlocks()) {
-                if (block.y >= 0) {
-                    sf::RectangleShape rect(sf::Vector2f(BLOCK_SIZE - 2, BLOCK_SIZE - 2));
-                    rect.setPosition(block.x * BLOCK_SIZE + 1, block.y * BLOCK_SIZE + 1);
-                    rect.setTexture(&blockTextures[currentPiece.type]);
-                    window.draw(rect);
-                }
+        }
+        if (!showHint || state != GameState::Playing || hintPosition == piecePosition) return;
+        if (hintTask.valid()) {
+            if (hintTaskPosition != piecePosition) {
+                *hintCancel = true;
             }
-            drawUI();
-            particles.draw(window);
-            break;
-        case GameState::Menu:
-            renderMenu();
-            break;
-        case GameState::Paused:
-            drawGridBackground();
-            drawUI();
-            renderPauseScreen();
-            break;
-        case GameState::GameOver:
-            drawGridBackground();
-            drawUI();
-            renderGameOver();
-            break;
-        case GameState::HowToPlay:
-            renderHowToPlay();
-            break;
-        case GameState::HighScores:
-            renderHighScores();
-            break;
-    }
-
-    window.display();
-}
-
-    void renderGame() {
-       window.clear(BACKGROUND_COLOR);
-        window.draw(backgroundSprite);
-
-        switch (state) {
-        case GameState::Playing:
-            renderGame();
-            break;
-        case GameState::Menu:
-            renderMenu();
-            break;
-        case GameState::Paused:
-            renderGame();
-            renderPauseScreen();
-            break;
-        case GameState::GameOver:
-            renderGame();
-            renderGameOver();
-            break;
-        case GameState::HowToPlay:
-            renderHowToPlay();
-            break;
-        case GameState::HighScores:
-            renderHighScores();
-            break;
+            return;
         }
 
-        window.display();
-    }
-
-    void renderMenu() {
-    logoSprite.setPosition(
-        (SCREEN_WIDTH - logoSprite.getGlobalBounds().width) / 2,
-        20
-    );
-    window.draw(logoSprite);
-
-    sf::Text creditText("Made by Najaf Ali", mainFont, 36);
-    creditText.setPosition(
-        (SCREEN_WIDTH - creditText.getGlobalBounds().width) / 2,
-        logoSprite.getPosition().y + logoSprite.getGlobalBounds().height + 14
-    );
-    creditText.setFillColor(sf::Color::White);
-    window.draw(creditText);
-
-    sf::Text mainTitle("TETRIS", titleFont, 150);
-    mainTitle.setStyle(sf::Text::Bold);
-    centerText(mainTitle, SCREEN_HEIGHT * 0.34f);
-    mainTitle.setFillColor(sf::Color::Yellow);
-    window.draw(mainTitle);
-
-    for (const auto& option : menuOptions) {
-        window.draw(option);
+        // The task gets copies of just what the search reads, never the engine
+        // itself (and with it the replay recorder).
+        std::vector<int> queue;
+        queue.push_back(engine.getCurrentPiece().type);
+        for (int i = 0; i < engine.getPreviewCount(); ++i) {
+            queue.push_back(engine.getPreviewType(i));
+        }
+        int hold = engine.hasHoldPiece() ? engine.getHoldPiece().type : -1;
+        Piece current(engine.getCurrentPiece().type);
+        Piece swapped = MoveGenerator::holdSwapPiece(engine);
+
+        hintTaskPosition = piecePosition;
+        PerfectClearSolver* solver = hintSolver.get();
+        hintCancel = std::make_shared<std::atomic<bool>>(false);
+        hintTask = std::async(std::launch::async, [solver, cancel = hintCancel, board = engine.getBoard(),
+            queue = std::move(queue), hold, canHold = engine.canHoldPiece(), current, swapped] {
+            PerfectClearHint result;
+            result.result = solver->solve(board, queue, hold, canHold, cancel.get());
+            if (result.result.status == PerfectClearStatus::Found) {
+                // Finesse is counted from the spawn position, as if the piece had not moved yet.
+                const Placement& first = result.result.steps.front().placement;
+                MoveGenerator generator;
+                generator.findFinesse(board, first.hold ? swapped : current, first.piece, result.finesse);
+                if (first.hold) {
+                    result.finesse.insert(result.finesse.begin(), FinesseKey::Hold);
+                }
+            }
+            return result;
+        });
     }
-}
-
-    void renderPauseScreen() {
-        sf::RectangleShape overlay(sf::Vector2f(SCREEN_WIDTH, SCREEN_HEIGHT));
-        overlay.setFillColor(sf::Color(0, 0, 0, 128));
-        window.draw(overlay);
 
-        sf::Text pauseText("PAUSED", titleFont, 60);
-        centerText(pauseText, SCREEN_HEIGHT / 2);
-        window.draw(pauseText);
-
-        sf::Text resumeText("Press ESC to resume", mainFont, 30);
-        centerText(resumeText, SCREEN_HEIGHT / 2 + 80);
-        window.draw(resumeText);
+    // The hint as the snapshot carries it: the placements to outline and its label.
+    void copyHint(FrameSnapshot& frame) const {
+        static const std::array<const char*, 9> KEY_NAMES = { "<", ">", "DAS<", "DAS>", "CW", "SD", "v", "HD", "HOLD" };
+        frame.hintPieceCount = 0;
+        std::string label;
+        if (hintPosition != piecePosition) {
+            label = "PC: searching...";
+        }
+        else if (hint.result.status == PerfectClearStatus::Found) {
+            for (const PerfectClearStep& step : hint.result.steps) {
+                frame.hintPieces[frame.hintPieceCount++] = step.placement.piece;
+                if (step.rowsCleared > 0) break;
+            }
+            label = "PC in " + std::to_string(hint.result.steps.size()) + ":";
+            for (FinesseKey key : hint.finesse) {
+                label += " ";
+                label += KEY_NAMES[static_cast<int>(key)];
+            }
+        }
+        else if (hint.result.status == PerfectClearStatus::None) {
+            label = "No PC in " + std::to_string(std::min(options.hintMaxPieces, engine.getPreviewCount() + (engine.hasHoldPiece() ? 2 : 1))) + " pieces";
+        }
+        else {
+            label = "PC: search limit reached";
+        }
+        std::snprintf(frame.hintLabel.data(), frame.hintLabel.size(), "%s", label.c_str());
     }
 
-    void renderGameOver() {
-        sf::RectangleShape overlay(sf::Vector2f(SCREEN_WIDTH, SCREEN_HEIGHT));
-        overlay.setFillColor(sf::Color(0, 0, 0, 200));
-        window.draw(overlay);
-
-        sf::Text gameOverTitle("GAME OVER", titleFont, 70);
-        centerText(gameOverTitle, SCREEN_HEIGHT * 0.3f);
-        gameOverTitle.setFillColor(sf::Color::Red);
-        window.draw(gameOverTitle);
-
-        std::stringstream ss;
-        ss << "Final Score: " << score << "\n";
-        ss << "High Score: " << highScore << "\n";
-        ss << "Lines Cleared: " << linesCleared << "\n";
-        ss << "Level Reached: " << level;
-
-        sf::Text statsText(ss.str(), mainFont, 30);
-        centerText(statsText, SCREEN_HEIGHT * 0.5f);
-        window.draw(statsText);
-
-        sf::Text restartText("Press SPACE to restart\nPress ESC to return to menu", mainFont, 25);
-        centerText(restartText, SCREEN_HEIGHT * 0.7f);
-        window.draw(restartText);
+    // Gravity comes from the recorded ticks, so the engine is never stepped here.
+    void updateReplay(float deltaTime) {
+        replayTime += deltaTime * replaySpeed;
+        std::uint32_t timeMs = static_cast<std::uint32_t>(replayTime * 1000.0f);
+        StepEvents events;
+        while (state == GameState::Playing && replayPlayer.playNext(engine, timeMs, events)) {
+            handleStepEvents(events);
+        }
+        if (state == GameState::Playing && replayPlayer.isFinished()) {
+            gameOver();
+        }
     }
 
-    void drawUI() {
-    window.draw(sidebar);
-
-    float sidebarCenterX = GRID_WIDTH * BLOCK_SIZE + (SIDEBAR_WIDTH / 2);
-
-    float logoScale = 0.7f;
-    logoSprite.setScale(logoScale, logoScale);
-    logoSprite.setPosition(
-        sidebarCenterX - (logoSprite.getGlobalBounds().width / 2),
-        20
-    );
-    window.draw(logoSprite);
-
-    sf::Text creditText("Made By Najaf Ali", mainFont, 24);
-    sf::FloatRect creditBounds = creditText.getLocalBounds();
-    creditText.setOrigin(creditBounds.width / 2, creditBounds.height / 2);
-    creditText.setPosition(
-        sidebarCenterX,
-        logoSprite.getPosition().y + logoSprite.getGlobalBounds().height + 20
-    );
-    creditText.setFillColor(sf::Color::White);
-    window.draw(creditText);
-
-    std::vector<std::pair<std::string, std::string>> stats = {
-        {"SCORE", std::to_string(score)},
-        {"LEVEL", std::to_string(level)},
-        {"LINES", std::to_string(linesCleared)},
-        {"HIGH SCORE", std::to_string(highScore)}
-    };
-
-    float startY = creditText.getPosition().y + creditText.getGlobalBounds().height + 40;
-    for (const auto& stat : stats) {
-        sf::Text labelText(stat.first, mainFont, 20);
-        sf::Text valueText(stat.second, mainFont, 30);
-
-        sf::FloatRect labelBounds = labelText.getLocalBounds();
-        sf::FloatRect valueBounds = valueText.getLocalBounds();
-
-        labelText.setOrigin(labelBounds.width / 2, labelBounds.height / 2);
-        valueText.setOrigin(valueBounds.width / 2, valueBounds.height / 2);
-
-        labelText.setPosition(sidebarCenterX, startY);
-        valueText.setPosition(sidebarCenterX, startY + 25);
-
-        labelText.setFillColor(sf::Color(200, 200, 200));
-        valueText.setFillColor(sf::Color::White);
-
-        window.draw(labelText);
-        window.draw(valueText);
-        startY += 80;
+    void render(const FrameSnapshot& frame) {
+        renderer.draw(window, frame);
+        ProfileScope scope(profiler, ProfilePhase::Display);
+        window.display();
     }
 
-    drawHoldPiece(startY);
-
-    drawNextPiece(startY + 120);
-}
-    void drawHoldPiece(float y) {
-        sf::Text holdText("HOLD", mainFont, 20);
-        holdText.setPosition(GRID_WIDTH * BLOCK_SIZE + 20, y);
-        holdText.setFillColor(sf::Color(200, 200, 200));
-        window.draw(holdText);
-
-        if (holdPiece.type != -1) {
-            const auto& shape = SHAPES[holdPiece.type][0];
-            for (size_t i = 0; i < shape.size(); ++i) {
-                for (size_t j = 0; j < shape[i].size(); ++j) {
-                    if (shape[i][j]) {
-                        sf::RectangleShape block(sf::Vector2f(BLOCK_SIZE - 2, BLOCK_SIZE - 2));
-                        block.setPosition(
-                            GRID_WIDTH * BLOCK_SIZE + 20 + j * BLOCK_SIZE,
-                            y + 30 + i * BLOCK_SIZE
-                        );
-                        block.setTexture(&blockTextures[holdPiece.type]);
-                        window.draw(block);
-                    }
+    // Draws the newest snapshot as often as the display allows. Frame pacing
+    // (vsync or the frame limit) blocks only this thread.
+    void renderLoop() {
+        try {
+            window.setActive(true);
+            sf::Clock renderClock;
+            std::uint64_t frameIndex = 0;
+            GameState previousState = snapshots.front().state;
+            while (!quitRequested) {
+                float deltaTime = std::min(renderClock.restart().asSeconds(), MAX_FRAME_TIME);
+                std::uint64_t allocationsBefore = AllocationCounter::count();
+                profiler.beginFrame();
+                snapshots.update();
+                const FrameSnapshot& frame = snapshots.front();
+                updateView(frame, deltaTime);
+                render(frame);
+                profiler.endFrame();
+
+                // With TETRIS_COUNT_ALLOCATIONS, report frames that allocate without a state change.
+                std::uint64_t allocations = AllocationCounter::count() - allocationsBefore;
+                if (AllocationCounter::isEnabled() && allocations > 0 && frame.state == previousState && frameIndex > 0) {
+                    std::cerr << "frame " << frameIndex << ": " << allocations << " heap allocations\n";
                 }
+                previousState = frame.state;
+                frameIndex++;
             }
+            window.setActive(false);
+        }
+        catch (const std::exception& e) {
+            renderError = e.what();
+            quitRequested = true;
         }
     }
 
-    void drawNextPiece(float y) {
-        sf::Text nextText("NEXT", mainFont, 20);
-        nextText.setPosition(GRID_WIDTH * BLOCK_SIZE + 20, y);
-        nextText.setFillColor(sf::Color(200, 200, 200));
-        window.draw(nextText);
-
-        const auto& shape = SHAPES[nextPiece.type][0];
-        for (size_t i = 0; i < shape.size(); ++i) {
-            for (size_t j = 0; j < shape[i].size(); ++j) {
-                if (shape[i][j]) {
-                    sf::RectangleShape block(sf::Vector2f(BLOCK_SIZE - 2, BLOCK_SIZE - 2));
-                    block.setPosition(
-                        GRID_WIDTH * BLOCK_SIZE + 20 + j * BLOCK_SIZE,
-                        y + 30 + i * BLOCK_SIZE
-                    );
-                    block.setTexture(&blockTextures[nextPiece.type]);
-                    window.draw(block);
-                }
-            }
+public:
+    ~Game() {
+        quitRequested = true;
+        if (hintCancel) {
+            *hintCancel = true;
         }
+        if (renderThread.joinable()) {
+            renderThread.join();
+        }
+        // Closing the window or quitting from the menu mid-game.
+        abandonGame();
     }
 
-public:
     void run() {
-        while (window.isOpen()) {
-            handleEvents();
-            update();
-            render();
+        publishSnapshot();
+        window.setActive(false);
+        renderThread = std::thread(&Game::renderLoop, this);
+
+        while (!quitRequested) {
+            {
+                ProfileScope scope(profiler, ProfilePhase::Events, FrameProfiler::SIMULATION_THREAD);
+                handleEvents();
+            }
+            {
+                ProfileScope scope(profiler, ProfilePhase::Update, FrameProfiler::SIMULATION_THREAD);
+                update();
+            }
+            publishSnapshot();
+            // Ticks are fixed-length, so the loop only has to come round about as
+            // often as the input thread samples keys.
+            sf::sleep(sf::milliseconds(1));
+        }
+
+        renderThread.join();
+        window.close();
+        if (!renderError.empty()) {
+            throw std::runtime_error(renderError);
+        }
+
+        if (options.profile) {
+            profiler.writeCsv("profile_frames.csv");
+            profiler.writeChromeTrace("profile_trace.json");
         }
     }
 };
 
-int main() {
-    srand(static_cast<unsigned>(time(0)));
+GameOptions parseOptions(int argc, char* argv[]) {
+    GameOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--seed" && hasValue) {
+            options.fixedSeed = true;
+            options.seed = std::stoull(argv[++i]);
+        }
+        else if (arg == "--replay" && hasValue) {
+            options.replayPath = argv[++i];
+        }
+        else if (arg == "--speed" && hasValue) {
+            options.replaySpeed = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--profile") {
+            options.profile = true;
+        }
+        else if (arg == "--tick-rate" && hasValue) {
+            options.tickRate = std::max(30, std::stoi(argv[++i]));
+        }
+        else if (arg == "--fps" && hasValue) {
+            options.frameLimit = std::max(0, std::stoi(argv[++i]));
+            options.vsync = false;
+        }
+        else if (arg == "--no-vsync") {
+            options.vsync = false;
+        }
+        else if (arg == "--das" && hasValue) {
+            options.autoShift.delay = std::max(0, std::stoi(argv[++i])) / 1000.0;
+        }
+        else if (arg == "--arr" && hasValue) {
+            options.autoShift.repeatInterval = std::max(0, std::stoi(argv[++i])) / 1000.0;
+        }
+        else if (arg == "--no-input-thread") {
+            options.inputThread = false;
+        }
+        else if (arg == "--autoplay") {
+            options.autoplay = true;
+        }
+        else if (arg == "--bot-pps" && hasValue) {
+            options.botPiecesPerSecond = std::max(0, std::stoi(argv[++i]));
+        }
+        else if (arg == "--bot-lookahead" && hasValue) {
+            options.botLookahead = std::max(0, std::min(std::stoi(argv[++i]), MAX_BOT_LOOKAHEAD));
+        }
+        else if (arg == "--bot-weights" && hasValue) {
+            if (!parseBotWeights(argv[++i], options.botWeights)) {
+                throw std::runtime_error("--bot-weights expects four comma-separated numbers");
+            }
+        }
+        else if (arg == "--pc-hint") {
+            options.hint = true;
+        }
+        else if (arg == "--pc-pieces" && hasValue) {
+            options.hintMaxPieces = std::max(1, std::min(std::stoi(argv[++i]), PerfectClearSolver::MAX_PIECES));
+        }
+        else if (arg == "--player" && hasValue) {
+            options.playerName = argv[++i];
+        }
+        else if (arg == "--preview" && hasValue) {
+            options.previewCount = std::max(1, std::min(std::stoi(argv[++i]), PieceQueue::MAX_PREVIEW));
+        }
+        else {
+            throw std::runtime_error("Unknown option: " + arg);
+        }
+    }
+    return options;
+}
 
+int main(int argc, char* argv[]) {
     try {
-        Game game;
+        Game game(parseOptions(argc, argv));
         game.run();
     }
     catch (const std::exception& e) {
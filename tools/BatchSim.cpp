@@ -0,0 +1,276 @@
+// Runs many games in lockstep on BatchEngine and compares it with a one-board-
+// at-a-time simulation built from the engine's own rules (isValidPosition,
+// dropDistance, Board::clearFullRows, and the lineClearScore and levelForLines
+// that TetrisEngine scores with).
+//
+//   BatchSim [--lanes N] [--steps N] [--seed N] [--verify]
+//
+// Without --verify it reports placements (boards advanced) per second for the
+// one-board reference and every batch kernel this CPU supports; the scalar
+// kernel, which places lanes one at a time, should roughly match the reference. With --verify the
+// kernels play a low-landing policy next to the reference and every lane's
+// rows, score, lines, level and pieces are compared after each step; the first
+// difference is printed and the exit status is 1.
+#include "../engine/BatchEngine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+    // Moves cycled through in the throughput runs. Columns stop at 6 so every
+    // rotation of every piece is in bounds.
+    const int MOVE_TABLES = 64;
+    const int MAX_MOVE_X = GRID_WIDTH - 4;
+
+    // One game at a time, the way TetrisEngine places a hard-dropped piece.
+    struct ReferenceGame {
+        Board board;
+        PieceQueue queue;
+        int currentType = 0;
+        int score = 0;
+        int level = 1;
+        int linesCleared = 0;
+        bool gameOver = false;
+
+        void reset(std::uint64_t seed) {
+            board.clear();
+            queue.reset(seed, EngineConfig().previewCount);
+            currentType = queue.pop();
+            score = 0;
+            level = 1;
+            linesCleared = 0;
+            gameOver = false;
+        }
+
+        void place(const BatchMove& move) {
+            if (gameOver) return;
+            Piece piece(currentType);
+            piece.rotation = move.rotation % ROTATION_COUNTS[currentType];
+            piece.x = move.x;
+            if (!isValidPosition(piece, board)) {
+                gameOver = true;
+                return;
+            }
+            piece.y += dropDistance(piece, board);
+            for (const Cell& block : piece.getBlocks()) {
+                board.setCell(block.x, block.y, piece.type + 1);
+            }
+            int rows = board.clearFullRows(piece.y, piece.y + piece.shape().height - 1).count;
+            if (rows > 0) {
+                score += lineClearScore(rows, level);
+                linesCleared += rows;
+                level = levelForLines(linesCleared);
+            }
+            currentType = queue.pop();
+            gameOver = !isValidPosition(Piece(currentType), board);
+        }
+    };
+
+    // The placement that lands lowest, so games last and clear rows.
+    BatchMove lowestMove(const ReferenceGame& game, Rng& rng) {
+        BatchMove best;
+        int bestRow = -1;
+        for (int rotation = 0; rotation < ROTATION_COUNTS[game.currentType]; ++rotation) {
+            Piece piece(game.currentType);
+            piece.rotation = rotation;
+            for (piece.x = 0; piece.x + piece.shape().width <= GRID_WIDTH; ++piece.x) {
+                if (!isValidPosition(piece, game.board)) continue;
+                int row = piece.y + dropDistance(piece, game.board) + piece.shape().height;
+                if (row > bestRow || (row == bestRow && rng.nextBelow(2) == 0)) {
+                    bestRow = row;
+                    best.rotation = static_cast<std::uint8_t>(rotation);
+                    best.x = static_cast<std::int8_t>(piece.x);
+                }
+            }
+        }
+        return best;
+    }
+
+    bool sameLane(const ReferenceGame& game, const BatchEngine& batch, int lane) {
+        if (game.gameOver != batch.isGameOver(lane) || game.score != batch.getScore(lane) ||
+            game.linesCleared != batch.getLinesCleared(lane) || game.level != batch.getLevel(lane) ||
+            game.currentType != batch.getCurrentType(lane)) {
+            return false;
+        }
+        for (int y = 0; y < GRID_HEIGHT; ++y) {
+            if (game.board.rows[y] != batch.getRow(lane, y)) return false;
+        }
+        return true;
+    }
+
+    std::vector<BatchKernel> supportedKernels() {
+        std::vector<BatchKernel> kernels;
+        for (BatchKernel kernel : { BatchKernel::Scalar, BatchKernel::Sse2, BatchKernel::Avx2 }) {
+            if (isBatchKernelSupported(kernel)) {
+                kernels.push_back(kernel);
+            }
+        }
+        return kernels;
+    }
+
+    int verify(int laneCount, int steps, std::uint64_t seed) {
+        std::vector<BatchKernel> kernels = supportedKernels();
+        std::vector<ReferenceGame> games(laneCount);
+        std::vector<std::unique_ptr<BatchEngine>> batches;
+        std::uint64_t nextSeed = seed;
+        for (BatchKernel kernel : kernels) {
+            batches.push_back(std::make_unique<BatchEngine>(laneCount, kernel));
+        }
+        for (int lane = 0; lane < laneCount; ++lane) {
+            games[lane].reset(nextSeed);
+            for (auto& batch : batches) {
+                batch->reset(lane, nextSeed);
+            }
+            nextSeed++;
+        }
+
+        Rng rng(seed);
+        std::vector<BatchMove> moves(laneCount);
+        std::uint64_t placements = 0;
+        std::uint64_t lines = 0;
+        for (int step = 0; step < steps; ++step) {
+            for (int lane = 0; lane < laneCount; ++lane) {
+                // Now and then an arbitrary move, which may not fit at all.
+                if (rng.nextBelow(16) == 0) {
+                    moves[lane].rotation = static_cast<std::uint8_t>(rng.nextBelow(4));
+                    moves[lane].x = static_cast<std::int8_t>(static_cast<int>(rng.nextBelow(GRID_WIDTH + 2)) - 1);
+                }
+                else {
+                    moves[lane] = lowestMove(games[lane], rng);
+                }
+                lines -= games[lane].linesCleared;
+                games[lane].place(moves[lane]);
+                lines += games[lane].linesCleared;
+            }
+            for (auto& batch : batches) {
+                batch->place(moves.data());
+            }
+            placements += laneCount;
+
+            for (std::size_t k = 0; k < batches.size(); ++k) {
+                for (int lane = 0; lane < laneCount; ++lane) {
+                    if (!sameLane(games[lane], *batches[k], lane)) {
+                        std::cout << "FAIL kernel=" << batchKernelName(kernels[k]) << " step=" << step << " lane=" << lane
+                            << " score=" << batches[k]->getScore(lane) << "/" << games[lane].score
+                            << " lines=" << batches[k]->getLinesCleared(lane) << "/" << games[lane].linesCleared
+                            << " over=" << batches[k]->isGameOver(lane) << "/" << games[lane].gameOver << "\n";
+                        return 1;
+                    }
+                }
+            }
+            for (int lane = 0; lane < laneCount; ++lane) {
+                if (!games[lane].gameOver) continue;
+                games[lane].reset(nextSeed);
+                for (auto& batch : batches) {
+                    batch->reset(lane, nextSeed);
+                }
+                nextSeed++;
+            }
+        }
+
+        std::cout << "OK kernels=";
+        for (std::size_t k = 0; k < kernels.size(); ++k) {
+            std::cout << (k ? "," : "") << batchKernelName(kernels[k]);
+        }
+        std::cout << " lanes=" << laneCount << " steps=" << steps << " placements=" << placements
+            << " lines=" << lines << " games=" << nextSeed - seed << "\n";
+        return 0;
+    }
+
+    // Runs steps placements in every lane, restarting finished games, and
+    // returns the seconds taken. place(moves) advances all lanes;
+    // finished(lane) and restart(lane, seed) handle game over.
+    template <class Place, class Finished, class Restart>
+    double timeRun(int laneCount, int steps, const std::vector<std::vector<BatchMove>>& tables,
+        Place place, Finished finished, Restart restart) {
+        std::uint64_t nextSeed = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int step = 0; step < steps; ++step) {
+            place(tables[step % tables.size()].data());
+            for (int lane = 0; lane < laneCount; ++lane) {
+                if (finished(lane)) {
+                    restart(lane, nextSeed++);
+                }
+            }
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void report(const char* name, int laneCount, int steps, double seconds, double referenceSeconds) {
+        double placements = static_cast<double>(laneCount) * steps;
+        std::cout << name << " placements_per_sec=" << (seconds > 0 ? placements / seconds : 0.0)
+            << " seconds=" << seconds << " speedup=" << (seconds > 0 ? referenceSeconds / seconds : 0.0) << "x\n";
+    }
+
+    void benchmark(int laneCount, int steps, std::uint64_t seed) {
+        Rng rng(seed);
+        std::vector<std::vector<BatchMove>> tables(MOVE_TABLES, std::vector<BatchMove>(laneCount));
+        for (auto& table : tables) {
+            for (BatchMove& move : table) {
+                move.rotation = static_cast<std::uint8_t>(rng.nextBelow(4));
+                move.x = static_cast<std::int8_t>(rng.nextBelow(MAX_MOVE_X + 1));
+            }
+        }
+
+        std::vector<ReferenceGame> games(laneCount);
+        for (int lane = 0; lane < laneCount; ++lane) {
+            games[lane].reset(lane);
+        }
+        double referenceSeconds = timeRun(laneCount, steps, tables,
+            [&](const BatchMove* moves) {
+                for (int lane = 0; lane < laneCount; ++lane) {
+                    games[lane].place(moves[lane]);
+                }
+            },
+            [&](int lane) { return games[lane].gameOver; },
+            [&](int lane, std::uint64_t laneSeed) { games[lane].reset(laneSeed); });
+        report("reference", laneCount, steps, referenceSeconds, referenceSeconds);
+
+        for (BatchKernel kernel : supportedKernels()) {
+            BatchEngine batch(laneCount, kernel);
+            double seconds = timeRun(laneCount, steps, tables,
+                [&](const BatchMove* moves) { batch.place(moves); },
+                [&](int lane) { return batch.isGameOver(lane); },
+                [&](int lane, std::uint64_t laneSeed) { batch.reset(lane, laneSeed); });
+            report(batchKernelName(kernel), laneCount, steps, seconds, referenceSeconds);
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int laneCount = 4096;
+    int steps = 0;
+    std::uint64_t seed = 1;
+    bool verifyOnly = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--lanes" && hasValue) {
+            laneCount = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--steps" && hasValue) {
+            steps = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--seed" && hasValue) {
+            seed = std::stoull(argv[++i]);
+        }
+        else if (arg == "--verify") {
+            verifyOnly = true;
+        }
+        else {
+            std::cerr << "usage: BatchSim [--lanes N] [--steps N] [--seed N] [--verify]\n";
+            return 2;
+        }
+    }
+
+    if (verifyOnly) {
+        return verify(laneCount, steps > 0 ? steps : 500, seed);
+    }
+    benchmark(laneCount, steps > 0 ? steps : 1000, seed);
+    return 0;
+}
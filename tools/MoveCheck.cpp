@@ -0,0 +1,240 @@
+// Checks MoveGenerator against a key-by-key replay on the board: every
+// placement generate() reports must have a findPath input sequence and a
+// findFinesse key sequence that, pressed one at a time with isValidPosition
+// deciding each move, leave the piece exactly there.
+//
+//   MoveCheck [--boards N] [--seed N]
+//
+// A fixed board covers a case a straight drop misses (a tuck under an
+// overhang, reached by stopping part way down a shaft); the rest are the empty
+// board and random stacks with holes and overhangs. The first mismatch is printed and the exit
+// status is 1.
+#include "../engine/MoveGenerator.h"
+#include "../engine/Random.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+    // Rows as drawn, top to bottom, for the bottom rows of a board; '#' is filled.
+    Board boardFromRows(const std::vector<std::string>& rows) {
+        Board board;
+        int top = GRID_HEIGHT - static_cast<int>(rows.size());
+        for (int i = 0; i < static_cast<int>(rows.size()); ++i) {
+            for (int x = 0; x < GRID_WIDTH; ++x) {
+                if (rows[i][x] == '#') {
+                    board.setCell(x, top + i, 1);
+                }
+            }
+        }
+        return board;
+    }
+
+    // Random columns of garbage with a dozen random cells flipped, for holes and
+    // overhangs. No row is left full.
+    Board randomBoard(Rng& rng) {
+        Board board;
+        for (int x = 0; x < GRID_WIDTH; ++x) {
+            int height = static_cast<int>(rng.nextBelow(9));
+            for (int y = GRID_HEIGHT - height; y < GRID_HEIGHT; ++y) {
+                board.setCell(x, y, 1);
+            }
+        }
+        for (int i = 0; i < 12; ++i) {
+            int x = static_cast<int>(rng.nextBelow(GRID_WIDTH));
+            int y = GRID_HEIGHT - 1 - static_cast<int>(rng.nextBelow(10));
+            if (board.isOccupied(x, y)) {
+                board.rows[y] &= static_cast<RowMask>(~(1u << x));
+            }
+            else {
+                board.setCell(x, y, 1);
+            }
+        }
+        for (int y = 0; y < GRID_HEIGHT; ++y) {
+            if (board.isRowFull(y)) {
+                board.rows[y] &= static_cast<RowMask>(~1u);
+            }
+        }
+        return board;
+    }
+
+    // A piece moved by single presses; a move that does not fit is refused.
+    struct KeyReplay {
+        const Board& board;
+        Piece piece;
+
+        bool move(int dx, int dy, int turns) {
+            Piece moved = piece;
+            moved.x += dx;
+            moved.y += dy;
+            moved.rotation = (moved.rotation + turns) % ROTATION_COUNTS[piece.type];
+            if (!isValidPosition(moved, board)) return false;
+            piece = moved;
+            return true;
+        }
+
+        void hold(int dx, int dy) {
+            while (move(dx, dy, 0)) {}
+        }
+
+        bool press(Input input) {
+            switch (input) {
+            case Input::MoveLeft: return move(-1, 0, 0);
+            case Input::MoveRight: return move(1, 0, 0);
+            case Input::SoftDrop: return move(0, 1, 0);
+            case Input::Rotate: return move(0, 0, 1);
+            case Input::HardDrop: hold(0, 1); return true;
+            default: return false;
+            }
+        }
+
+        bool press(FinesseKey key) {
+            switch (key) {
+            case FinesseKey::Left: return move(-1, 0, 0);
+            case FinesseKey::Right: return move(1, 0, 0);
+            case FinesseKey::DasLeft: hold(-1, 0); return true;
+            case FinesseKey::DasRight: hold(1, 0); return true;
+            case FinesseKey::Rotate: return move(0, 0, 1);
+            case FinesseKey::SoftDrop: hold(0, 1); return true;
+            case FinesseKey::Down: return move(0, 1, 0);
+            case FinesseKey::HardDrop: hold(0, 1); return true;
+            default: return false;
+            }
+        }
+
+        bool at(const Piece& target) const {
+            int rotations = ROTATION_COUNTS[piece.type];
+            return piece.x == target.x && piece.y == target.y && piece.rotation % rotations == target.rotation % rotations;
+        }
+    };
+
+    std::string describe(const Piece& piece) {
+        return "type " + std::to_string(piece.type) + " at (" + std::to_string(piece.x) + ", " +
+            std::to_string(piece.y) + ") rotation " + std::to_string(piece.rotation);
+    }
+
+    // Checks one placement; prints the failure and returns false on a mismatch.
+    bool checkPlacement(MoveGenerator& generator, const Board& board, const Piece& target,
+        std::vector<Input>& inputs, std::vector<FinesseKey>& keys) {
+        Piece start(target.type);
+        if (!generator.findPath(board, start, target, inputs)) {
+            std::cerr << "findPath found no path to " << describe(target) << "\n";
+            return false;
+        }
+        KeyReplay path{ board, start };
+        for (Input input : inputs) {
+            if (!path.press(input)) {
+                std::cerr << "findPath to " << describe(target) << " presses a key that does not move\n";
+                return false;
+            }
+        }
+        if (!path.at(target)) {
+            std::cerr << "findPath to " << describe(target) << " ends at " << describe(path.piece) << "\n";
+            return false;
+        }
+
+        if (!generator.findFinesse(board, start, target, keys)) {
+            std::cerr << "findFinesse found no keys for " << describe(target) << "\n";
+            return false;
+        }
+        KeyReplay finesse{ board, start };
+        for (FinesseKey key : keys) {
+            if (!finesse.press(key)) {
+                std::cerr << "findFinesse to " << describe(target) << " presses a key that does not move\n";
+                return false;
+            }
+        }
+        if (!finesse.at(target)) {
+            std::cerr << "findFinesse to " << describe(target) << " ends at " << describe(finesse.piece) << "\n";
+            return false;
+        }
+        // Every input is also a key, so finesse never needs more presses.
+        if (keys.size() > inputs.size()) {
+            std::cerr << "findFinesse to " << describe(target) << " takes " << keys.size() <<
+                " keys where findPath takes " << inputs.size() << " inputs\n";
+            return false;
+        }
+        return true;
+    }
+
+    // Checks every placement of every piece type on board; returns how many.
+    int checkBoard(MoveGenerator& generator, const Board& board, bool& ok) {
+        std::vector<Placement> placements;
+        std::vector<Input> inputs;
+        std::vector<FinesseKey> keys;
+        int checked = 0;
+        for (int type = 0; type < PIECE_TYPES && ok; ++type) {
+            placements.clear();
+            generator.generate(board, Piece(type), placements);
+            for (const Placement& placement : placements) {
+                if (!checkPlacement(generator, board, placement.piece, inputs, keys)) {
+                    ok = false;
+                    break;
+                }
+                checked++;
+            }
+        }
+        return checked;
+    }
+
+    // An O piece that has to stop two rows short of the shaft's floor and
+    // slide left into the cave; dropping to the floor first leaves it stuck.
+    bool checkTuck(MoveGenerator& generator) {
+        Board board = boardFromRows({
+            "#####..###",
+            "#......###",
+            "#......###",
+            "#####..###",
+            "#####..###",
+            "#####..###",
+        });
+        Piece target(3);
+        target.x = 1;
+        target.y = GRID_HEIGHT - 5;
+        std::vector<Input> inputs;
+        std::vector<FinesseKey> keys;
+        if (!checkPlacement(generator, board, target, inputs, keys)) {
+            std::cerr << "tuck under an overhang failed\n";
+            return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int boardCount = 200;
+    std::uint64_t seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--boards" && i + 1 < argc) {
+            boardCount = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::stoull(argv[++i]);
+        }
+        else {
+            std::cerr << "usage: MoveCheck [--boards N] [--seed N]\n";
+            return 2;
+        }
+    }
+
+    MoveGenerator generator;
+    if (!checkTuck(generator)) {
+        return 1;
+    }
+
+    bool ok = true;
+    int checked = checkBoard(generator, Board(), ok);
+    Rng rng(seed);
+    for (int i = 0; i < boardCount && ok; ++i) {
+        checked += checkBoard(generator, randomBoard(rng), ok);
+    }
+    if (!ok) {
+        return 1;
+    }
+    std::cout << "checked " << checked << " placements on " << boardCount + 1 << " boards\n";
+    return 0;
+}
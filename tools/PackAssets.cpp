@@ -0,0 +1,88 @@
+// Packs every file in a resource directory into one resource pack, or checks
+// an existing pack.
+//
+//   PackAssets <resource directory> <output pack>
+//   PackAssets --verify <pack>
+//
+// Entries are named by their path relative to the directory, with '/'
+// separators. --verify recomputes every entry's CRC-32 and exits with 1 on a
+// mismatch.
+#include "../engine/ResourcePack.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+    int verifyPack(const std::string& path) {
+        ResourcePack pack;
+        if (!pack.open(path)) {
+            std::cerr << pack.getError() << "\n";
+            return 1;
+        }
+        int failures = 0;
+        for (const PackEntry& entry : pack.getEntries()) {
+            bool ok = pack.verify(entry);
+            failures += ok ? 0 : 1;
+            std::printf("%-4s %-36s %10llu bytes\n", ok ? "OK" : "BAD", entry.name.c_str(),
+                static_cast<unsigned long long>(entry.size));
+        }
+        std::printf("%zu entries, %d bad\n", pack.getEntries().size(), failures);
+        return failures ? 1 : 0;
+    }
+
+    int buildPack(const fs::path& directory, const std::string& output) {
+        std::vector<fs::path> files;
+        for (const auto& entry : fs::recursive_directory_iterator(directory)) {
+            if (entry.is_regular_file()) {
+                files.push_back(entry.path());
+            }
+        }
+        // Sorted so the same inputs always produce the same pack.
+        std::sort(files.begin(), files.end());
+
+        std::vector<ResourcePack::Source> sources;
+        std::uint64_t totalBytes = 0;
+        for (const auto& file : files) {
+            std::ifstream in(file, std::ios::binary);
+            if (!in.is_open()) {
+                std::cerr << "cannot read " << file.string() << "\n";
+                return 1;
+            }
+            ResourcePack::Source source;
+            source.name = fs::relative(file, directory).generic_string();
+            source.bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            totalBytes += source.bytes.size();
+            std::printf("%-36s %10zu bytes  crc %08x\n", source.name.c_str(), source.bytes.size(),
+                crc32(source.bytes.data(), source.bytes.size()));
+            sources.push_back(std::move(source));
+        }
+
+        if (!ResourcePack::write(output, sources)) {
+            std::cerr << "cannot write " << output << "\n";
+            return 1;
+        }
+        std::printf("packed %zu files (%llu bytes) into %s\n", sources.size(),
+            static_cast<unsigned long long>(totalBytes), output.c_str());
+        return 0;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 3 && std::string(argv[1]) == "--verify") {
+        return verifyPack(argv[2]);
+    }
+    if (argc != 3 || !fs::is_directory(argv[1])) {
+        std::cerr << "usage: PackAssets <resource directory> <output pack>\n"
+            "       PackAssets --verify <pack>\n";
+        return 2;
+    }
+    return buildPack(argv[1], argv[2]);
+}
@@ -0,0 +1,93 @@
+// Plays recorded replays through the headless engine as fast as possible and
+// checks that each one reproduces the score, lines and level it was saved with.
+//
+//   ReplayRunner [--repeat N] <replay files or directories>...
+//
+// Exits with 1 if any replay fails to load or diverges, so a folder of replays
+// works as a regression corpus for engine changes.
+#include "../engine/TetrisEngine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+    void collectReplays(const fs::path& path, std::vector<fs::path>& out) {
+        if (fs::is_directory(path)) {
+            for (const auto& entry : fs::directory_iterator(path)) {
+                if (entry.path().extension() == ".trp") {
+                    out.push_back(entry.path());
+                }
+            }
+        }
+        else {
+            out.push_back(path);
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int repeat = 1;
+    std::vector<fs::path> paths;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--repeat" && i + 1 < argc) {
+            repeat = std::max(1, std::stoi(argv[++i]));
+        }
+        else {
+            collectReplays(arg, paths);
+        }
+    }
+    if (paths.empty()) {
+        std::cerr << "usage: ReplayRunner [--repeat N] <replay files or directories>...\n";
+        return 2;
+    }
+
+    TetrisEngine engine;
+    int failures = 0;
+    std::uint64_t totalEvents = 0;
+    std::uint64_t games = 0;
+    double gameSeconds = 0.0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (const auto& path : paths) {
+        Replay replay;
+        if (!replay.load(path.string())) {
+            std::cout << "FAIL " << path.string() << " (unreadable)\n";
+            failures++;
+            continue;
+        }
+
+        ReplayPlayer player(replay);
+        for (int r = 0; r < repeat; ++r) {
+            player.start(engine);
+            player.playToEnd(engine);
+        }
+        totalEvents += static_cast<std::uint64_t>(replay.events.size()) * repeat;
+        games += repeat;
+        gameSeconds += replay.durationMs / 1000.0 * repeat;
+
+        bool matches = engine.getScore() == replay.finalScore &&
+            engine.getLinesCleared() == replay.finalLines &&
+            engine.getLevel() == replay.finalLevel;
+        std::cout << (matches ? "OK   " : "FAIL ") << path.string()
+            << " score=" << engine.getScore() << "/" << replay.finalScore
+            << " lines=" << engine.getLinesCleared() << "/" << replay.finalLines
+            << " level=" << engine.getLevel() << "/" << replay.finalLevel
+            << " events=" << replay.events.size() << "\n";
+        if (!matches) failures++;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "replays=" << paths.size() << " games=" << games << " failures=" << failures
+        << " events=" << totalEvents << " seconds=" << seconds
+        << " events_per_sec=" << (seconds > 0 ? totalEvents / seconds : 0.0)
+        << " speedup=" << (seconds > 0 ? gameSeconds / seconds : 0.0) << "x\n";
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,363 @@
+// Tunes the bot's board-evaluation weights with a genetic algorithm. Every
+// generation, each candidate weight set plays the same fixed-seed headless games
+// (one game per thread-pool task, spread over all cores) and is scored by the
+// lines it clears; the fittest candidates breed replacements for the weakest.
+//
+//   Tuner [--population N] [--games N] [--pieces N] [--generations N]
+//         [--lookahead N] [--threads N] [--seed N] [--checkpoint FILE]
+//
+// With --checkpoint the population is saved after every generation and a run
+// started with an existing checkpoint resumes from it. The best weights are
+// printed in the form the game's --bot-weights option takes.
+#include "../engine/Bot.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    const char* const CHECKPOINT_HEADER = "tuner-checkpoint 1";
+    // Share of the population replaced by offspring each generation.
+    const double REPLACED_FRACTION = 0.3;
+    // Share of the population drawn into each parent-selection tournament.
+    const double TOURNAMENT_FRACTION = 0.1;
+    const double MUTATION_CHANCE = 0.05;
+    const double MUTATION_STEP = 0.2;
+
+    struct Candidate {
+        // Only the direction matters to the bot's choices, so weights are kept
+        // at unit length.
+        std::array<double, 4> weights{};
+        std::int64_t fitness = 0;
+    };
+
+    struct TunerState {
+        std::uint64_t seed = 0;
+        int generation = 0;
+        std::vector<Candidate> population;
+        Candidate best;
+        bool hasBest = false;
+    };
+
+    struct GameResult {
+        int lines = 0;
+        int pieces = 0;
+    };
+
+    BotWeights toBotWeights(const std::array<double, 4>& weights) {
+        BotWeights botWeights;
+        botWeights.aggregateHeight = weights[0];
+        botWeights.linesCleared = weights[1];
+        botWeights.holes = weights[2];
+        botWeights.bumpiness = weights[3];
+        return botWeights;
+    }
+
+    std::string formatWeights(const std::array<double, 4>& weights) {
+        std::ostringstream out;
+        out << std::setprecision(6) << weights[0] << "," << weights[1] << "," << weights[2] << "," << weights[3];
+        return out.str();
+    }
+
+    void normalize(std::array<double, 4>& weights) {
+        double length = 0.0;
+        for (double weight : weights) {
+            length += weight * weight;
+        }
+        length = std::sqrt(length);
+        if (length == 0.0) {
+            weights = { -1.0, 0.0, 0.0, 0.0 };
+            return;
+        }
+        for (double& weight : weights) {
+            weight /= length;
+        }
+    }
+
+    // Uniform in [-1, 1).
+    double nextSigned(Rng& rng) {
+        return rng.nextFloat() * 2.0 - 1.0;
+    }
+
+    GameResult playGame(const BotConfig& config, std::uint64_t seed, int maxPieces) {
+        TetrisEngine engine;
+        engine.reset(seed);
+        Bot bot(config);
+        BotMove move;
+        GameResult result;
+        while (result.pieces < maxPieces && bot.chooseMove(engine, move)) {
+            for (Input input : move.inputs) {
+                engine.applyInput(input);
+            }
+            result.pieces++;
+            if (engine.isGameOver()) break;
+        }
+        result.lines = engine.getLinesCleared();
+        return result;
+    }
+
+    // Two of a random sample of the population, fittest first.
+    std::pair<int, int> tournament(const std::vector<Candidate>& population, Rng& rng) {
+        int size = static_cast<int>(population.size());
+        int sample = std::max(2, static_cast<int>(size * TOURNAMENT_FRACTION));
+        int first = -1;
+        int second = -1;
+        for (int i = 0; i < sample; ++i) {
+            int pick = static_cast<int>(rng.nextBelow(static_cast<std::uint32_t>(size)));
+            if (first == -1 || population[pick].fitness > population[first].fitness) {
+                second = first;
+                first = pick;
+            }
+            else if (pick != first && (second == -1 || population[pick].fitness > population[second].fitness)) {
+                second = pick;
+            }
+        }
+        if (second == -1) {
+            second = (first + 1) % size;
+        }
+        return { first, second };
+    }
+
+    // The child lies between its parents, nearer the fitter one, and
+    // occasionally has one weight nudged.
+    Candidate breed(const Candidate& a, const Candidate& b, Rng& rng) {
+        double fitnessA = static_cast<double>(std::max<std::int64_t>(a.fitness, 0));
+        double fitnessB = static_cast<double>(std::max<std::int64_t>(b.fitness, 0));
+        if (fitnessA + fitnessB == 0.0) {
+            fitnessA = fitnessB = 1.0;
+        }
+        Candidate child;
+        for (std::size_t i = 0; i < child.weights.size(); ++i) {
+            child.weights[i] = a.weights[i] * fitnessA + b.weights[i] * fitnessB;
+        }
+        normalize(child.weights);
+        if (rng.nextFloat() < MUTATION_CHANCE) {
+            child.weights[rng.nextBelow(4)] += nextSigned(rng) * MUTATION_STEP;
+            normalize(child.weights);
+        }
+        return child;
+    }
+
+    bool saveCheckpoint(const std::string& path, const TunerState& state) {
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::trunc);
+            if (!file.is_open()) return false;
+            file << std::setprecision(17);
+            file << CHECKPOINT_HEADER << "\n";
+            file << "seed " << state.seed << "\n";
+            file << "generation " << state.generation << "\n";
+            file << "population " << state.population.size() << "\n";
+            for (const Candidate& candidate : state.population) {
+                file << candidate.weights[0] << " " << candidate.weights[1] << " " << candidate.weights[2] << " "
+                    << candidate.weights[3] << "\n";
+            }
+            file << "best " << (state.hasBest ? 1 : 0) << " " << state.best.fitness << " " << state.best.weights[0]
+                << " " << state.best.weights[1] << " " << state.best.weights[2] << " " << state.best.weights[3] << "\n";
+            file.flush();
+            if (!file.good()) return false;
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary, path, error);
+        return !error;
+    }
+
+    bool loadCheckpoint(const std::string& path, TunerState& state) {
+        std::ifstream file(path);
+        std::string header;
+        if (!std::getline(file, header) || header != CHECKPOINT_HEADER) return false;
+
+        std::string key;
+        std::size_t count = 0;
+        TunerState loaded;
+        if (!(file >> key >> loaded.seed) || key != "seed") return false;
+        if (!(file >> key >> loaded.generation) || key != "generation") return false;
+        if (!(file >> key >> count) || key != "population" || count < 2) return false;
+        loaded.population.resize(count);
+        for (Candidate& candidate : loaded.population) {
+            for (double& weight : candidate.weights) {
+                if (!(file >> weight)) return false;
+            }
+        }
+        int hasBest = 0;
+        if (!(file >> key >> hasBest >> loaded.best.fitness) || key != "best") return false;
+        for (double& weight : loaded.best.weights) {
+            if (!(file >> weight)) return false;
+        }
+        loaded.hasBest = hasBest != 0;
+        state = std::move(loaded);
+        return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int populationSize = 100;
+    int games = 20;
+    int maxPieces = 500;
+    int generations = 20;
+    int lookahead = 0;
+    unsigned threads = 0;
+    std::uint64_t seed = 1;
+    std::string checkpointPath;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--population" && hasValue) {
+            populationSize = std::max(2, std::stoi(argv[++i]));
+        }
+        else if (arg == "--games" && hasValue) {
+            games = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--pieces" && hasValue) {
+            maxPieces = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--generations" && hasValue) {
+            generations = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--lookahead" && hasValue) {
+            lookahead = std::max(0, std::min(std::stoi(argv[++i]), 2));
+        }
+        else if (arg == "--threads" && hasValue) {
+            threads = static_cast<unsigned>(std::max(0, std::stoi(argv[++i])));
+        }
+        else if (arg == "--seed" && hasValue) {
+            seed = std::stoull(argv[++i]);
+        }
+        else if (arg == "--checkpoint" && hasValue) {
+            checkpointPath = argv[++i];
+        }
+        else {
+            std::cerr << "usage: Tuner [--population N] [--games N] [--pieces N] [--generations N]\n"
+                "             [--lookahead N] [--threads N] [--seed N] [--checkpoint FILE]\n";
+            return 2;
+        }
+    }
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    TunerState state;
+    if (!checkpointPath.empty() && std::filesystem::exists(checkpointPath)) {
+        if (!loadCheckpoint(checkpointPath, state)) {
+            std::cerr << "cannot read checkpoint " << checkpointPath << "\n";
+            return 1;
+        }
+        std::cout << "resuming " << checkpointPath << " at generation " << state.generation
+            << " (population " << state.population.size() << ", seed " << state.seed << ")\n";
+    }
+    else {
+        state.seed = seed;
+        Rng rng(seed);
+        state.population.resize(populationSize);
+        for (Candidate& candidate : state.population) {
+            for (double& weight : candidate.weights) {
+                weight = nextSigned(rng);
+            }
+            normalize(candidate.weights);
+        }
+    }
+
+    // The calling thread plays games too, so the pool gets one thread fewer.
+    std::unique_ptr<ThreadPool> pool;
+    if (threads > 1) {
+        pool = std::make_unique<ThreadPool>(threads - 1);
+    }
+
+    int population = static_cast<int>(state.population.size());
+    std::vector<GameResult> results(static_cast<std::size_t>(population) * games);
+    std::vector<std::uint64_t> gameSeeds(games);
+    std::cout << "population=" << population << " games=" << games << " pieces=" << maxPieces
+        << " lookahead=" << lookahead << " threads=" << threads << "\n";
+
+    int lastGeneration = state.generation + generations;
+    for (; state.generation < lastGeneration; ++state.generation) {
+        // Everything random in a generation comes from its own generator, so a
+        // resumed run continues exactly as an uninterrupted one would.
+        Rng rng(state.seed + 0x9E3779B97F4A7C15ull * (state.generation + 1));
+        for (std::uint64_t& gameSeed : gameSeeds) {
+            gameSeed = rng.next();
+        }
+
+        // One task per (candidate, game) pair; the tasks share nothing but
+        // their slot in results.
+        auto start = std::chrono::steady_clock::now();
+        auto playTask = [&](int task) {
+            BotConfig config;
+            config.weights = toBotWeights(state.population[task / games].weights);
+            config.lookahead = lookahead;
+            results[task] = playGame(config, gameSeeds[task % games], maxPieces);
+        };
+        int tasks = population * games;
+        if (pool) {
+            pool->parallelFor(tasks, playTask);
+        }
+        else {
+            for (int task = 0; task < tasks; ++task) {
+                playTask(task);
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::int64_t totalPieces = 0;
+        std::int64_t totalFitness = 0;
+        for (int c = 0; c < population; ++c) {
+            Candidate& candidate = state.population[c];
+            candidate.fitness = 0;
+            for (int g = 0; g < games; ++g) {
+                const GameResult& result = results[static_cast<std::size_t>(c) * games + g];
+                candidate.fitness += result.lines;
+                totalPieces += result.pieces;
+            }
+            totalFitness += candidate.fitness;
+        }
+        std::stable_sort(state.population.begin(), state.population.end(),
+            [](const Candidate& a, const Candidate& b) { return a.fitness > b.fitness; });
+        // Fitness is only comparable within a generation (each plays different
+        // seeds), so the best of the latest generation is what is reported.
+        state.best = state.population.front();
+        state.hasBest = true;
+
+        std::cout << "generation=" << state.generation + 1
+            << " best_lines_per_game=" << static_cast<double>(state.best.fitness) / games
+            << " mean_lines_per_game=" << static_cast<double>(totalFitness) / (static_cast<double>(population) * games)
+            << " best_weights=" << formatWeights(state.best.weights)
+            << " seconds=" << seconds
+            << " games_per_sec=" << (seconds > 0 ? tasks / seconds : 0.0)
+            << " pieces_per_sec=" << (seconds > 0 ? totalPieces / seconds : 0.0) << "\n";
+
+        // The weakest share of the population is replaced by children of
+        // tournament winners.
+        int replaced = std::max(1, static_cast<int>(population * REPLACED_FRACTION));
+        std::vector<Candidate> children;
+        for (int i = 0; i < replaced; ++i) {
+            std::pair<int, int> parents = tournament(state.population, rng);
+            children.push_back(breed(state.population[parents.first], state.population[parents.second], rng));
+        }
+        std::copy(children.begin(), children.end(), state.population.end() - replaced);
+
+        if (!checkpointPath.empty()) {
+            TunerState saved = state;
+            saved.generation = state.generation + 1;
+            if (!saveCheckpoint(checkpointPath, saved)) {
+                std::cerr << "cannot write checkpoint " << checkpointPath << "\n";
+                return 1;
+            }
+        }
+    }
+
+    if (state.hasBest) {
+        std::cout << "best --bot-weights " << formatWeights(state.best.weights) << "\n";
+    }
+    return 0;
+}